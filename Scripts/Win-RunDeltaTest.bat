@@ -0,0 +1,12 @@
+set binFolder="..\bin\Release-x86_64-windows\RoadefGoogleChallenge\"
+set nbMoves=1000000
+
+call Win-Compile.bat
+
+pushd %binFolder%
+    pushd Assets\Instances
+        for %%x in (*.txt) do ..\..\RoadefGoogleChallenge.exe test %%x ..\Solutions\%%x %nbMoves%
+    popd
+popd
+
+pause
\ No newline at end of file
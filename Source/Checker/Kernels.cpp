@@ -0,0 +1,331 @@
+#include "Kernels.hpp"
+
+#include "Log/Log.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNELS_TARGET(x)
+#else
+#define KERNELS_TARGET(x) __attribute__((target(x)))
+#endif
+
+namespace Kernels
+{
+#ifdef KERNELS_X86
+	// -------- AVX2 ----------------------------- //
+
+	// Exact modulo 2^64 as long as the second operand fits in 32 unsigned bits, AVX2 has no 64 bits multiplication.
+	KERNELS_TARGET("avx2")
+	static inline __m256i multiplyAVX2(__m256i values, __m256i factors)
+	{
+		const __m256i low = _mm256_mul_epu32(values, factors);
+		const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(values, 32), factors);
+
+		return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+	}
+
+	KERNELS_TARGET("avx2")
+	static inline int64 sumAVX2(__m256i values)
+	{
+		const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+
+		return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+	}
+
+	KERNELS_TARGET("avx2")
+	static int64 calculateLoadCostAVX2(const int64* machineResourcesUsage, const int64* safetyLimits, const int64* loadCostWeights, int64 nbResources)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+
+		__m256i machineLoadCost = zero;
+		for (ResourceID resourceID = 0; resourceID < nbResources; resourceID += 4)
+		{
+			const __m256i usage = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(machineResourcesUsage + resourceID));
+			const __m256i safetyLimit = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(safetyLimits + resourceID));
+			const __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(loadCostWeights + resourceID));
+
+			__m256i cost = _mm256_sub_epi64(usage, safetyLimit);
+			cost = _mm256_and_si256(cost, _mm256_cmpgt_epi64(cost, zero));
+
+			machineLoadCost = _mm256_add_epi64(machineLoadCost, multiplyAVX2(cost, weight));
+		}
+
+		return sumAVX2(machineLoadCost);
+	}
+
+	KERNELS_TARGET("avx2")
+	static int64 calculateBalanceCostAVX2(const int64* machineResourcesUsage, const int64* capacities, const BalanceObjectivesTable& balanceObjectives, int64 nbBalanceObjectives)
+	{
+		const long long* usage = reinterpret_cast<const long long*>(machineResourcesUsage);
+		const long long* capacity = reinterpret_cast<const long long*>(capacities);
+
+		__m256i machineBalanceCost = _mm256_setzero_si256();
+		for (BalanceObjectiveID balanceObjectiveID = 0; balanceObjectiveID < nbBalanceObjectives; balanceObjectiveID += sVectorisedNbBalanceObjectives)
+		{
+			const __m256i firstResourcesIDs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(balanceObjectives.firstResourcesIDs + balanceObjectiveID));
+			const __m256i secondResourcesIDs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(balanceObjectives.secondResourcesIDs + balanceObjectiveID));
+			const __m256i targetRatios = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(balanceObjectives.targetRatios + balanceObjectiveID));
+			const __m256i costWeights = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(balanceObjectives.costWeights + balanceObjectiveID));
+
+			const __m256i firstRemaining = _mm256_sub_epi64(_mm256_i64gather_epi64(capacity, firstResourcesIDs, 8), _mm256_i64gather_epi64(usage, firstResourcesIDs, 8));
+			const __m256i secondRemaining = _mm256_sub_epi64(_mm256_i64gather_epi64(capacity, secondResourcesIDs, 8), _mm256_i64gather_epi64(usage, secondResourcesIDs, 8));
+
+			__m256i cost = _mm256_sub_epi64(multiplyAVX2(firstRemaining, targetRatios), secondRemaining);
+			cost = _mm256_and_si256(cost, _mm256_cmpgt_epi64(cost, _mm256_setzero_si256()));
+
+			machineBalanceCost = _mm256_add_epi64(machineBalanceCost, multiplyAVX2(cost, costWeights));
+		}
+
+		return sumAVX2(machineBalanceCost);
+	}
+
+	KERNELS_TARGET("avx2")
+	static bool checkCapacityAVX2(const int64* machineResourcesUsage, const int64* capacities, int64 nbResources)
+	{
+		__m256i isViolated = _mm256_setzero_si256();
+		for (ResourceID resourceID = 0; resourceID < nbResources; resourceID += 4)
+		{
+			const __m256i usage = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(machineResourcesUsage + resourceID));
+			const __m256i capacity = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(capacities + resourceID));
+
+			isViolated = _mm256_or_si256(isViolated, _mm256_cmpgt_epi64(usage, capacity));
+		}
+
+		return _mm256_testz_si256(isViolated, isViolated);
+	}
+
+	KERNELS_TARGET("avx2")
+	static void filterMachinesAVX2(const int64* requirements, const int64* machinesHeadrooms, int64 nbMachines, int64 nbPaddedResources, uint64* feasibleMachinesMask)
+	{
+		for (int64 wordID = 0; wordID < (nbMachines + 63) / 64; ++wordID)
+			feasibleMachinesMask[wordID] = 0;
+
+		// Most instances have at most 4 resources, the requirements then stay in a single register
+		if (nbPaddedResources == 4)
+		{
+			const __m256i requirement = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(requirements));
+
+			for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+			{
+				const __m256i headroom = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(machinesHeadrooms + machineID * 4));
+				const __m256i doesNotFit = _mm256_cmpgt_epi64(requirement, headroom);
+
+				feasibleMachinesMask[machineID / 64] |= static_cast<uint64>(_mm256_testz_si256(doesNotFit, doesNotFit)) << (machineID % 64);
+			}
+
+			return;
+		}
+
+		for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+		{
+			const int64* machineHeadroom = machinesHeadrooms + machineID * nbPaddedResources;
+
+			__m256i doesNotFit = _mm256_setzero_si256();
+			for (ResourceID resourceID = 0; resourceID < nbPaddedResources; resourceID += 4)
+			{
+				const __m256i requirement = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(requirements + resourceID));
+				const __m256i headroom = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(machineHeadroom + resourceID));
+
+				doesNotFit = _mm256_or_si256(doesNotFit, _mm256_cmpgt_epi64(requirement, headroom));
+			}
+
+			feasibleMachinesMask[machineID / 64] |= static_cast<uint64>(_mm256_testz_si256(doesNotFit, doesNotFit)) << (machineID % 64);
+		}
+	}
+
+	// -------- SSE4.2 --------------------------- //
+
+	KERNELS_TARGET("sse4.2")
+	static inline __m128i multiplySSE42(__m128i values, __m128i factors)
+	{
+		const __m128i low = _mm_mul_epu32(values, factors);
+		const __m128i high = _mm_mul_epu32(_mm_srli_epi64(values, 32), factors);
+
+		return _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+	}
+
+	KERNELS_TARGET("sse4.2")
+	static int64 calculateLoadCostSSE42(const int64* machineResourcesUsage, const int64* safetyLimits, const int64* loadCostWeights, int64 nbResources)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i machineLoadCost = zero;
+		for (ResourceID resourceID = 0; resourceID < nbResources; resourceID += 2)
+		{
+			const __m128i usage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(machineResourcesUsage + resourceID));
+			const __m128i safetyLimit = _mm_loadu_si128(reinterpret_cast<const __m128i*>(safetyLimits + resourceID));
+			const __m128i weight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(loadCostWeights + resourceID));
+
+			__m128i cost = _mm_sub_epi64(usage, safetyLimit);
+			cost = _mm_and_si128(cost, _mm_cmpgt_epi64(cost, zero));
+
+			machineLoadCost = _mm_add_epi64(machineLoadCost, multiplySSE42(cost, weight));
+		}
+
+		return _mm_cvtsi128_si64(machineLoadCost) + _mm_extract_epi64(machineLoadCost, 1);
+	}
+
+	KERNELS_TARGET("sse4.2")
+	static bool checkCapacitySSE42(const int64* machineResourcesUsage, const int64* capacities, int64 nbResources)
+	{
+		__m128i isViolated = _mm_setzero_si128();
+		for (ResourceID resourceID = 0; resourceID < nbResources; resourceID += 2)
+		{
+			const __m128i usage = _mm_loadu_si128(reinterpret_cast<const __m128i*>(machineResourcesUsage + resourceID));
+			const __m128i capacity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(capacities + resourceID));
+
+			isViolated = _mm_or_si128(isViolated, _mm_cmpgt_epi64(usage, capacity));
+		}
+
+		return _mm_testz_si128(isViolated, isViolated);
+	}
+
+	KERNELS_TARGET("sse4.2")
+	static void filterMachinesSSE42(const int64* requirements, const int64* machinesHeadrooms, int64 nbMachines, int64 nbPaddedResources, uint64* feasibleMachinesMask)
+	{
+		for (int64 wordID = 0; wordID < (nbMachines + 63) / 64; ++wordID)
+			feasibleMachinesMask[wordID] = 0;
+
+		for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+		{
+			const int64* machineHeadroom = machinesHeadrooms + machineID * nbPaddedResources;
+
+			__m128i doesNotFit = _mm_setzero_si128();
+			for (ResourceID resourceID = 0; resourceID < nbPaddedResources; resourceID += 2)
+			{
+				const __m128i requirement = _mm_loadu_si128(reinterpret_cast<const __m128i*>(requirements + resourceID));
+				const __m128i headroom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(machineHeadroom + resourceID));
+
+				doesNotFit = _mm_or_si128(doesNotFit, _mm_cmpgt_epi64(requirement, headroom));
+			}
+
+			feasibleMachinesMask[machineID / 64] |= static_cast<uint64>(_mm_testz_si128(doesNotFit, doesNotFit)) << (machineID % 64);
+		}
+	}
+#endif
+
+	// ------------------------------------------- //
+
+	InstructionSet detectInstructionSet()
+	{
+#if defined(KERNELS_X86) && defined(_MSC_VER)
+		int registers[4];
+
+		__cpuid(registers, 0);
+		const int maxLeaf = registers[0];
+
+		__cpuid(registers, 1);
+		const bool hasSSE42 = (registers[2] & (1 << 20)) != 0;
+		const bool hasOSXSave = (registers[2] & (1 << 27)) != 0;
+		const bool hasAVX = (registers[2] & (1 << 28)) != 0;
+
+		// AVX registers also need to be saved by the OS
+		bool hasAVX2 = false;
+		if (maxLeaf >= 7 && hasOSXSave && hasAVX && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(registers, 7, 0);
+			hasAVX2 = (registers[1] & (1 << 5)) != 0;
+		}
+
+		if (hasAVX2)
+			return InstructionSet::AVX2;
+		if (hasSSE42)
+			return InstructionSet::SSE42;
+#elif defined(KERNELS_X86)
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2"))
+			return InstructionSet::AVX2;
+		if (__builtin_cpu_supports("sse4.2"))
+			return InstructionSet::SSE42;
+#endif
+
+		return InstructionSet::Scalar;
+	}
+
+	template<int64 NbResources>
+	static void selectResourcesKernels(KernelTable& table, int64 nbResources)
+	{
+		if constexpr (NbResources > sMaxSpecialisedNbResources)
+		{
+			table.calculateLoadCost = &calculateLoadCost<sDynamicSize>;
+			table.checkCapacity = &checkCapacity<sDynamicSize>;
+			table.addRequirements = &addRequirements<sDynamicSize>;
+			table.removeRequirements = &removeRequirements<sDynamicSize>;
+			table.filterMachines = &filterMachines<sDynamicSize>;
+
+			APP_INFO("No evaluation kernels specialised for {0} resources, using the generic ones.", nbResources);
+		}
+		else if (nbResources == NbResources)
+		{
+			table.calculateLoadCost = &calculateLoadCost<NbResources>;
+			table.checkCapacity = &checkCapacity<NbResources>;
+			table.addRequirements = &addRequirements<NbResources>;
+			table.removeRequirements = &removeRequirements<NbResources>;
+			table.filterMachines = &filterMachines<NbResources>;
+		}
+		else
+			selectResourcesKernels<NbResources + 1>(table, nbResources);
+	}
+
+	template<int64 NbBalanceObjectives>
+	static void selectBalanceKernels(KernelTable& table, int64 nbBalanceObjectives)
+	{
+		if constexpr (NbBalanceObjectives > sMaxSpecialisedNbBalanceObjectives)
+		{
+			table.calculateBalanceCost = &calculateBalanceCost<sDynamicSize>;
+
+			APP_INFO("No evaluation kernels specialised for {0} balance objectives, using the generic ones.", nbBalanceObjectives);
+		}
+		else if (nbBalanceObjectives == NbBalanceObjectives)
+			table.calculateBalanceCost = &calculateBalanceCost<NbBalanceObjectives>;
+		else
+			selectBalanceKernels<NbBalanceObjectives + 1>(table, nbBalanceObjectives);
+	}
+
+	KernelTable selectKernels(int64 nbResources, int64 nbBalanceObjectives, bool canBeVectorised)
+	{
+		KernelTable table;
+		table.nbResources = nbResources;
+		table.nbBalanceObjectives = nbBalanceObjectives;
+		table.instructionSet = canBeVectorised ? detectInstructionSet() : InstructionSet::Scalar;
+
+		selectResourcesKernels<1>(table, nbResources);
+		selectBalanceKernels<0>(table, nbBalanceObjectives);
+
+#ifdef KERNELS_X86
+		switch (table.instructionSet)
+		{
+		case InstructionSet::AVX2:
+			table.calculateLoadCost = &calculateLoadCostAVX2;
+			table.checkCapacity = &checkCapacityAVX2;
+			table.filterMachines = &filterMachinesAVX2;
+
+			if (nbBalanceObjectives >= sVectorisedNbBalanceObjectives)
+				table.calculateBalanceCost = &calculateBalanceCostAVX2;
+
+			APP_INFO("Using AVX2 evaluation kernels.");
+			break;
+
+		case InstructionSet::SSE42:
+			table.calculateLoadCost = &calculateLoadCostSSE42;
+			table.checkCapacity = &checkCapacitySSE42;
+			table.filterMachines = &filterMachinesSSE42;
+
+			APP_INFO("Using SSE4.2 evaluation kernels.");
+			break;
+
+		case InstructionSet::Scalar:
+			APP_INFO("Using scalar evaluation kernels.");
+			break;
+		}
+#endif
+
+		return table;
+	}
+}
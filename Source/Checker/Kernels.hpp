@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Core.hpp"
+
+/*
+Hot evaluation kernels, specialised at compile time on the number of resources and of balance objectives.
+With the sizes known, the compiler fully unrolls the loops and keeps a whole usage row in registers.
+The kernels are selected once, after the data is loaded, and a generic version handles the other sizes.
+
+When the CPU supports it, AVX2 or SSE4.2 versions of the cost and capacity kernels are used instead.
+They work on whole registers, so every row they read must be padded with zeros up to Data::getNbPaddedResources,
+and the balance objectives table up to a multiple of sVectorisedNbBalanceObjectives.
+Their multiplications are 64 x 32 bits, so they are only exact when weights and ratios fit in 32 unsigned bits.
+*/
+
+namespace Kernels
+{
+	// Template argument used by the generic kernels, the size is then given at runtime.
+	static constexpr int64 sDynamicSize = -1;
+
+	static constexpr int64 sMaxSpecialisedNbResources = 12;
+	static constexpr int64 sMaxSpecialisedNbBalanceObjectives = 2;
+
+	// Balance objectives handled per AVX2 iteration, below that the unrolled scalar kernels are faster than gathers.
+	static constexpr int64 sVectorisedNbBalanceObjectives = 4;
+
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE42,
+		AVX2
+	};
+
+	struct BalanceObjectivesTable
+	{
+		const int64* firstResourcesIDs;
+		const int64* secondResourcesIDs;
+		const int64* targetRatios;
+		const int64* costWeights;
+	};
+
+	typedef int64	(*LoadCostKernel)			(const int64* machineResourcesUsage, const int64* safetyLimits, const int64* loadCostWeights, int64 nbResources);
+	typedef int64	(*BalanceCostKernel)		(const int64* machineResourcesUsage, const int64* capacities, const BalanceObjectivesTable& balanceObjectives, int64 nbBalanceObjectives);
+	typedef bool	(*CapacityKernel)			(const int64* machineResourcesUsage, const int64* capacities, int64 nbResources);
+	typedef void	(*RequirementsKernel)		(int64* machineResourcesUsage, const int64* requirements, int64 nbResources);
+	typedef void	(*FilterMachinesKernel)		(const int64* requirements, const int64* machinesHeadrooms, int64 nbMachines, int64 nbPaddedResources, uint64* feasibleMachinesMask);
+
+	struct KernelTable
+	{
+		LoadCostKernel		calculateLoadCost;
+		BalanceCostKernel	calculateBalanceCost;
+		CapacityKernel		checkCapacity;
+		RequirementsKernel	addRequirements;
+		RequirementsKernel	removeRequirements;
+		FilterMachinesKernel filterMachines;
+
+		int64 nbResources;
+		int64 nbBalanceObjectives;
+
+		InstructionSet instructionSet;
+	};
+
+	InstructionSet detectInstructionSet();
+	KernelTable selectKernels(int64 nbResources, int64 nbBalanceObjectives, bool canBeVectorised);
+
+	template<int64 NbResources>
+	int64 calculateLoadCost(const int64* machineResourcesUsage, const int64* safetyLimits, const int64* loadCostWeights, int64 nbResources)
+	{
+		const int64 size = NbResources == sDynamicSize ? nbResources : NbResources;
+
+		int64 machineLoadCost = 0;
+		for (ResourceID resourceID = 0; resourceID < size; ++resourceID)
+		{
+			const int64 cost = machineResourcesUsage[resourceID] - safetyLimits[resourceID];
+			machineLoadCost += (0 < cost ? cost : 0) * loadCostWeights[resourceID];
+		}
+
+		return machineLoadCost;
+	}
+
+	template<int64 NbBalanceObjectives>
+	int64 calculateBalanceCost(const int64* machineResourcesUsage, const int64* capacities, const BalanceObjectivesTable& balanceObjectives, int64 nbBalanceObjectives)
+	{
+		const int64 size = NbBalanceObjectives == sDynamicSize ? nbBalanceObjectives : NbBalanceObjectives;
+
+		int64 machineBalanceCost = 0;
+		for (BalanceObjectiveID balanceObjectiveID = 0; balanceObjectiveID < size; ++balanceObjectiveID)
+		{
+			const ResourceID firstResourceID = balanceObjectives.firstResourcesIDs[balanceObjectiveID];
+			const ResourceID secondResourceID = balanceObjectives.secondResourcesIDs[balanceObjectiveID];
+
+			const int64 A1 = balanceObjectives.targetRatios[balanceObjectiveID] * (capacities[firstResourceID] - machineResourcesUsage[firstResourceID]);
+			const int64 A2 = capacities[secondResourceID] - machineResourcesUsage[secondResourceID];
+
+			const int64 cost = A1 - A2;
+			machineBalanceCost += balanceObjectives.costWeights[balanceObjectiveID] * (0 < cost ? cost : 0);
+		}
+
+		return machineBalanceCost;
+	}
+
+	template<int64 NbResources>
+	bool checkCapacity(const int64* machineResourcesUsage, const int64* capacities, int64 nbResources)
+	{
+		const int64 size = NbResources == sDynamicSize ? nbResources : NbResources;
+
+		// No early exit, so that the specialised versions compile to branchless code
+		bool isRespected = true;
+		for (ResourceID resourceID = 0; resourceID < size; ++resourceID)
+			isRespected &= machineResourcesUsage[resourceID] <= capacities[resourceID];
+
+		return isRespected;
+	}
+
+	/*
+	Tests one requirements row against the headrooms of every machine, stored as a contiguous [MachineID][padded ResourceID] array.
+	Bit machineID of the mask (one uint64 per 64 machines) is set when the requirements fit in the machine's headroom.
+	*/
+	template<int64 NbResources>
+	void filterMachines(const int64* requirements, const int64* machinesHeadrooms, int64 nbMachines, int64 nbPaddedResources, uint64* feasibleMachinesMask)
+	{
+		const int64 size = NbResources == sDynamicSize ? nbPaddedResources : NbResources;
+
+		for (int64 wordID = 0; wordID < (nbMachines + 63) / 64; ++wordID)
+			feasibleMachinesMask[wordID] = 0;
+
+		for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+		{
+			const int64* machineHeadroom = machinesHeadrooms + machineID * nbPaddedResources;
+
+			bool isFeasible = true;
+			for (ResourceID resourceID = 0; resourceID < size; ++resourceID)
+				isFeasible &= requirements[resourceID] <= machineHeadroom[resourceID];
+
+			feasibleMachinesMask[machineID / 64] |= static_cast<uint64>(isFeasible) << (machineID % 64);
+		}
+	}
+
+	inline bool isMachineInMask(const uint64* machinesMask, MachineID machineID) { return (machinesMask[machineID / 64] >> (machineID % 64)) & 1; }
+
+	template<int64 NbResources>
+	void addRequirements(int64* machineResourcesUsage, const int64* requirements, int64 nbResources)
+	{
+		const int64 size = NbResources == sDynamicSize ? nbResources : NbResources;
+
+		for (ResourceID resourceID = 0; resourceID < size; ++resourceID)
+			machineResourcesUsage[resourceID] += requirements[resourceID];
+	}
+
+	template<int64 NbResources>
+	void removeRequirements(int64* machineResourcesUsage, const int64* requirements, int64 nbResources)
+	{
+		const int64 size = NbResources == sDynamicSize ? nbResources : NbResources;
+
+		for (ResourceID resourceID = 0; resourceID < size; ++resourceID)
+			machineResourcesUsage[resourceID] -= requirements[resourceID];
+	}
+}
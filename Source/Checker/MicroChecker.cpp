@@ -1,14 +1,50 @@
 #include "MicroChecker.hpp"
 
-bool MicroChecker::checkMachineCapacityConstraints(MachineID machineID, const std::vector<int64>& machineResourcesUsage)
+#include <algorithm>
+
+MicroChecker::MicroChecker(const std::shared_ptr<Data>& data)
+	: mData(data)
 {
-	for (ResourceID resourceID = 0; resourceID < mData->getNbResources(); ++resourceID)
+	const int64 nbResources = mData->getNbResources();
+	const int64 nbBalanceObjectives = mData->getNbBalanceObjectives();
+
+	// Padded with zeros for the vectorised kernels, padding objectives then cost nothing
+	const int64 nbPaddedBalanceObjectives = (nbBalanceObjectives + Kernels::sVectorisedNbBalanceObjectives - 1) / Kernels::sVectorisedNbBalanceObjectives * Kernels::sVectorisedNbBalanceObjectives;
+
+	mLoadCostWeights = std::vector<int64>(mData->getNbPaddedResources(), 0);
+	for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+		mLoadCostWeights[resourceID] = mData->getResourceLoadCostWeight(resourceID);
+
+	mBalanceObjectivesFirstResources = std::vector<int64>(nbPaddedBalanceObjectives, 0);
+	mBalanceObjectivesSecondResources = std::vector<int64>(nbPaddedBalanceObjectives, 0);
+	mBalanceObjectivesTargetRatios = std::vector<int64>(nbPaddedBalanceObjectives, 0);
+	mBalanceObjectivesCostWeights = std::vector<int64>(nbPaddedBalanceObjectives, 0);
+	for (BalanceObjectiveID balanceObjectiveID = 0; balanceObjectiveID < nbBalanceObjectives; ++balanceObjectiveID)
 	{
-		if (machineResourcesUsage[resourceID] > mData->getResourceCapacity(machineID, resourceID))
-			return false;
+		mBalanceObjectivesFirstResources[balanceObjectiveID] = mData->getBalanceObjectiveFirstResource(balanceObjectiveID);
+		mBalanceObjectivesSecondResources[balanceObjectiveID] = mData->getBalanceObjectiveSecondResource(balanceObjectiveID);
+		mBalanceObjectivesTargetRatios[balanceObjectiveID] = mData->getBalanceObjectiveTargetRatio(balanceObjectiveID);
+		mBalanceObjectivesCostWeights[balanceObjectiveID] = mData->getBalanceObjectiveCostWeight(balanceObjectiveID);
 	}
 
-	return true;
+	mBalanceObjectivesTable.firstResourcesIDs = mBalanceObjectivesFirstResources.data();
+	mBalanceObjectivesTable.secondResourcesIDs = mBalanceObjectivesSecondResources.data();
+	mBalanceObjectivesTable.targetRatios = mBalanceObjectivesTargetRatios.data();
+	mBalanceObjectivesTable.costWeights = mBalanceObjectivesCostWeights.data();
+
+	// The vectorised kernels multiply by 32 unsigned bits factors only
+	const auto fitsInUnsigned32Bits = [](int64 factor) { return 0 <= factor && factor <= 0xFFFFFFFFLL; };
+
+	bool canBeVectorised = std::all_of(mLoadCostWeights.begin(), mLoadCostWeights.end(), fitsInUnsigned32Bits)
+						&& std::all_of(mBalanceObjectivesTargetRatios.begin(), mBalanceObjectivesTargetRatios.end(), fitsInUnsigned32Bits)
+						&& std::all_of(mBalanceObjectivesCostWeights.begin(), mBalanceObjectivesCostWeights.end(), fitsInUnsigned32Bits);
+
+	mKernels = Kernels::selectKernels(nbResources, nbBalanceObjectives, canBeVectorised);
+}
+
+bool MicroChecker::checkMachineCapacityConstraints(MachineID machineID, const std::vector<int64>& machineResourcesUsage)
+{
+	return mKernels.checkCapacity(machineResourcesUsage.data(), mData->getResourceCapacities(machineID).data(), mKernels.nbResources);
 }
 
 bool MicroChecker::checkServiceConflictConstraints(const Solution& solution, ServiceID serviceID)
@@ -110,29 +146,19 @@ bool MicroChecker::checkMachineTransientResourcesConstraints(const Solution& sol
 
 bool MicroChecker::checkSwapConflictConstraints(const Solution& solution, const Swap& swap)
 {
-	const ProcessID& processID1 = swap.processID1;
-	const ProcessID& processID2 = swap.processID2;
-
-	const auto& serviceProcessesIDs1 = mData->getServiceProcessesIDs(mData->getServiceID(processID1));
-	const auto& serviceProcessesIDs2 = mData->getServiceProcessesIDs(mData->getServiceID(processID2));
-
-	// First process
-	for (ProcessID processID : serviceProcessesIDs1)
-	{
-		if (processID == processID1)
-			continue;
+	return checkProcessConflictConstraints(solution, swap.processID1) && checkProcessConflictConstraints(solution, swap.processID2);
+}
 
-		if (solution[processID] == solution[processID1])
-			return false;
-	}
+bool MicroChecker::checkProcessConflictConstraints(const Solution& solution, ProcessID processID)
+{
+	const auto& serviceProcessesIDs = mData->getServiceProcessesIDs(mData->getServiceID(processID));
 
-	// Second process
-	for (ProcessID processID : serviceProcessesIDs2)
+	for (ProcessID otherProcessID : serviceProcessesIDs)
 	{
-		if (processID == processID2)
+		if (otherProcessID == processID)
 			continue;
 
-		if (solution[processID] == solution[processID2])
+		if (solution[otherProcessID] == solution[processID])
 			return false;
 	}
 
@@ -141,38 +167,20 @@ bool MicroChecker::checkSwapConflictConstraints(const Solution& solution, const
 
 int64 MicroChecker::calculateMachineLoadCost(MachineID machineID, const MachinesResourcesUsage& machinesResourcesUsage)
 {
-	const int64 nbResources = mData->getNbResources();
-
-	int64 machineLoadCost = 0;
-	for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
-	{
-		const int64 cost = machinesResourcesUsage[machineID][resourceID] - mData->getResourceSafetyLimit(machineID, resourceID);
-
-		int64 resourceLoadCost = 0 < cost ? cost : 0;
-		resourceLoadCost *= mData->getResourceLoadCostWeight(resourceID);
-		machineLoadCost += resourceLoadCost;
-	}
-
-	return machineLoadCost;
+	return calculateMachineLoadCost(machineID, machinesResourcesUsage[machineID].data());
 }
 
 int64 MicroChecker::calculateMachineBalanceCost(MachineID machineID, const MachinesResourcesUsage& machinesResourcesUsage)
 {
-	const int64 nbBalanceObjectives = mData->getNbBalanceObjectives();
-
-	int64 machineBalanceCost = 0;
-	for (BalanceObjectiveID balanceObjectiveID = 0; balanceObjectiveID < nbBalanceObjectives; ++balanceObjectiveID)
-	{
-		ResourceID firstResourceID = mData->getBalanceObjectiveFirstResource(balanceObjectiveID);
-		ResourceID secondResourceID = mData->getBalanceObjectiveSecondResource(balanceObjectiveID);
-		int64 targetRatio = mData->getBalanceObjectiveTargetRatio(balanceObjectiveID);
-
-		int64 A1 = targetRatio * (mData->getResourceCapacity(machineID, firstResourceID) - machinesResourcesUsage[machineID][firstResourceID]);
-		int64 A2 = mData->getResourceCapacity(machineID, secondResourceID) - machinesResourcesUsage[machineID][secondResourceID];
-
-		int64 cost = A1 - A2;
-		machineBalanceCost += mData->getBalanceObjectiveCostWeight(balanceObjectiveID) * cost;
-	}
+	return calculateMachineBalanceCost(machineID, machinesResourcesUsage[machineID].data());
+}
 
-	return machineBalanceCost;
+int64 MicroChecker::calculateMachineLoadCost(MachineID machineID, const int64* machineResourcesUsage)
+{
+	return mKernels.calculateLoadCost(machineResourcesUsage, mData->getResourceSafetyLimits(machineID).data(), mLoadCostWeights.data(), mKernels.nbResources);
 }
+
+int64 MicroChecker::calculateMachineBalanceCost(MachineID machineID, const int64* machineResourcesUsage)
+{
+	return mKernels.calculateBalanceCost(machineResourcesUsage, mData->getResourceCapacities(machineID).data(), mBalanceObjectivesTable, mKernels.nbBalanceObjectives);
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Core.hpp"
 
+#include "Checker/Kernels.hpp"
 #include "Data/Data.hpp"
 #include "Solver/Swap.hpp"
 
@@ -11,7 +12,7 @@ class MicroChecker
 {
 public:
 	MicroChecker() = delete;
-	MicroChecker(const std::shared_ptr<Data>& data) : mData(data) {}
+	MicroChecker(const std::shared_ptr<Data>& data);
 
 	bool checkMachineCapacityConstraints(MachineID machineID, const std::vector<int64>& machineResourcesUsage);
 	bool checkServiceConflictConstraints(const Solution& solution, ServiceID serviceID);
@@ -20,10 +21,27 @@ public:
 	bool checkMachineTransientResourcesConstraints(const Solution& solution, MachineID machineID, const std::vector<int64>& machineResourcesUsage);
 
 	bool checkSwapConflictConstraints(const Solution& solution, const Swap& swap);
+	bool checkProcessConflictConstraints(const Solution& solution, ProcessID processID);
 
 	int64 calculateMachineLoadCost(MachineID machineID, const MachinesResourcesUsage& machinesResourcesUsage);
 	int64 calculateMachineBalanceCost(MachineID machineID, const MachinesResourcesUsage& machinesResourcesUsage);
 
+	// Same with any padded usage row, for usages that are not applied yet
+	int64 calculateMachineLoadCost(MachineID machineID, const int64* machineResourcesUsage);
+	int64 calculateMachineBalanceCost(MachineID machineID, const int64* machineResourcesUsage);
+
+	inline const Kernels::KernelTable& getKernels() const { return mKernels; }
+
 private:
 	std::shared_ptr<Data> mData;
+
+	// Kernels specialised on the instance sizes, and the data they read stored contiguously
+	Kernels::KernelTable mKernels;
+
+	std::vector<int64> mLoadCostWeights;
+	std::vector<int64> mBalanceObjectivesFirstResources;
+	std::vector<int64> mBalanceObjectivesSecondResources;
+	std::vector<int64> mBalanceObjectivesTargetRatios;
+	std::vector<int64> mBalanceObjectivesCostWeights;
+	Kernels::BalanceObjectivesTable mBalanceObjectivesTable;
 };
\ No newline at end of file
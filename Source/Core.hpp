@@ -43,6 +43,7 @@
 // -------- TYPES ---------------------------- //
 
 typedef long long int64;
+typedef unsigned long long uint64;
 
 typedef int64 MachineID;
 typedef int64 ProcessID;
@@ -50,11 +51,13 @@ typedef int64 ResourceID;
 typedef int64 ServiceID;
 typedef int64 BalanceObjectiveID;
 typedef int64 LocationID;
+typedef int64 NeighbourhoodID;
 
 #include <vector>
 typedef std::vector<std::vector<ProcessID>>	MachinesProcessesIDs;		// [MachineID]
 typedef std::vector<std::vector<int64>>		MachinesResourcesUsage;		// [MachineID][ResourceID]
 typedef std::vector<std::vector<int64>>		ServicesLocationsSpreads;	// [ServiceID][LocationID]
+typedef std::vector<std::vector<int64>>		ServicesNeighbourhoodsCounts;	// [ServiceID][NeighbourhoodID]
 
 typedef std::vector<MachineID> Solution;
 
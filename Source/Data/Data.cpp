@@ -18,6 +18,8 @@ static constexpr int64 maxNbDependencies = 5000;
 static constexpr int64 maxNbLocations = 1000;
 static constexpr int64 maxNbBalanceObjectives = 10;
 
+static constexpr int64 resourcesRowsAlignment = 4; // Number of int64 in an AVX2 register
+
 static std::string readFileContent(const std::string& filepath);
 
 // Vector of components, which are vectors of lines. Order: Resources, Machines, Services, Processes, Balance objectives, Weights
@@ -272,8 +274,28 @@ Data::Data(const std::string& instancePath, const std::string& initialSolutionPa
 
 	if (isEverythingLoaded) APP_INFO("Data successfully loaded.");
 
+	// Pad every per resource row with zeros, so that vectorised kernels only work on whole registers
+	mNbPaddedResources = (static_cast<int64>(mResources.size()) + resourcesRowsAlignment - 1) / resourcesRowsAlignment * resourcesRowsAlignment;
+
+	for (auto& machine : mMachines)
+		machine.padResources(mNbPaddedResources);
+
+	for (auto& process : mProcesses)
+		process.padResources(mNbPaddedResources);
+
 	// Precalculate things
 	mMachinesInitialProcesses = calculateMachinesProcesses(mInitialSolution);
+
+	mServicesDependingServices = std::vector<std::vector<ServiceID>>(mServices.size());
+	for (ServiceID serviceID = 0; serviceID < getNbServices(); ++serviceID)
+	{
+		for (ServiceID dependencyID : mServices[serviceID].getDependencies())
+			mServicesDependingServices[dependencyID].push_back(serviceID);
+	}
+
+	mLocationsMachinesIDs = std::vector<std::vector<MachineID>>(mNbLocations);
+	for (MachineID machineID = 0; machineID < getNbMachines(); ++machineID)
+		mLocationsMachinesIDs[getMachineLocation(machineID)].push_back(machineID);
 }
 
 void Data::attachSolution(const std::string& solutionPath)
@@ -302,7 +324,7 @@ void Data::saveNewSolutionToFile(const std::string& filepath)
 
 MachinesResourcesUsage Data::calculateMachinesResourcesUsage(const Solution& solution) const
 {
- 	MachinesResourcesUsage machinesResourcesUsages(mMachines.size(), std::vector<int64>(mResources.size(), 0));
+ 	MachinesResourcesUsage machinesResourcesUsages(mMachines.size(), std::vector<int64>(mNbPaddedResources, 0));
 
 	for (ProcessID processID = 0; processID < mProcesses.size(); ++processID)
 	{
@@ -333,6 +355,16 @@ ServicesLocationsSpreads Data::calculateServicesLocationsSpreads(const Solution
 	return servicesLocationsSpreads;
 }
 
+ServicesNeighbourhoodsCounts Data::calculateServicesNeighbourhoodsCounts(const Solution& solution) const
+{
+	ServicesNeighbourhoodsCounts servicesNeighbourhoodsCounts(mServices.size(), std::vector<int64>(mNbNeighbourhoods, 0));
+
+	for (ProcessID processID = 0; processID < getNbProcesses(); ++processID)
+		++servicesNeighbourhoodsCounts[getServiceID(processID)][getMachineNeighbourhood(solution[processID])];
+
+	return servicesNeighbourhoodsCounts;
+}
+
 static std::string readFileContent(const std::string& filepath)
 {
 	std::string contents;
@@ -26,6 +26,7 @@ public:
 	inline int64 getNbProcesses() const { return mProcesses.size(); }
 	inline int64 getNbMachines() const { return mMachines.size(); }
 	inline int64 getNbResources() const { return mResources.size(); }
+	inline int64 getNbPaddedResources() const { return mNbPaddedResources; }
 	inline int64 getNbServices() const { return mServices.size(); }
 	inline int64 getNbBalanceObjectives() const { return mBalanceObjectives.size(); }
 	inline int64 getNbLocations() const { return mNbLocations; }
@@ -37,6 +38,7 @@ public:
 	inline int64 getMachineMoveCost(MachineID oldMachineID, MachineID newMachineID)	const { return mMachines[oldMachineID].getMoveCost(newMachineID); }
 	inline int64 getMachineLocation(MachineID machineID) const { return mMachines[machineID].getLocation(); }
 	inline int64 getMachineNeighbourhood(MachineID machineID) const { return mMachines[machineID].getNeighbourhood(); }
+	inline const std::vector<MachineID>& getLocationMachinesIDs(LocationID locationID) const { return mLocationsMachinesIDs[locationID]; }
 
 	inline const std::vector<ResourceID>& getTransientResourcesIDs() const { return mTransientResourcesIDs; }
 	inline int64 getResourceRequirement(ProcessID processID, ResourceID resourceID) const { return mProcesses[processID].getResourceRequirement(resourceID); }
@@ -44,9 +46,14 @@ public:
 	inline int64 getResourceCapacity(MachineID machineID, ResourceID resourceID) const { return mMachines[machineID].getCapacity(resourceID); }
 	inline int64 getResourceLoadCostWeight(ResourceID resourceID) const { return mResources[resourceID].getLoadCostWeight(); }
 
+	inline const std::vector<int64>& getResourceRequirements(ProcessID processID) const { return mProcesses[processID].getRequirements(); }
+	inline const std::vector<int64>& getResourceSafetyLimits(MachineID machineID) const { return mMachines[machineID].getSafetyLimits(); }
+	inline const std::vector<int64>& getResourceCapacities(MachineID machineID) const { return mMachines[machineID].getCapacities(); }
+
 	inline ServiceID getServiceID(ProcessID processID) const { return mProcesses[processID].getService(); }
 	inline const std::vector<ProcessID>& getServiceProcessesIDs(ServiceID serviceID) const { return mServices[serviceID].getProcessIDs(); }
 	inline const std::vector<ServiceID>& getServiceDependencies(ServiceID serviceID) const { return mServices[serviceID].getDependencies(); }
+	inline const std::vector<ServiceID>& getServiceDependingServices(ServiceID serviceID) const { return mServicesDependingServices[serviceID]; }
 	inline int64 getServiceSpreadMin(ServiceID serviceID) const { return mServices[serviceID].getSpreadMin(); }
 
 	inline ResourceID getBalanceObjectiveFirstResource(BalanceObjectiveID balanceObjectiveID) const { return mBalanceObjectives[balanceObjectiveID].getFirstResourceID(); }
@@ -67,10 +74,12 @@ public:
 	MachinesProcessesIDs calculateMachinesProcesses(const Solution& solution) const;
 
 	ServicesLocationsSpreads calculateServicesLocationsSpreads(const Solution& solution) const;
+	ServicesNeighbourhoodsCounts calculateServicesNeighbourhoodsCounts(const Solution& solution) const;
 
 private:
 	std::vector<Resource> mResources;
 	std::vector<ResourceID> mTransientResourcesIDs;
+	int64 mNbPaddedResources = 0;
 
 	std::vector<Process> mProcesses;
 	std::vector<Machine> mMachines;
@@ -86,6 +95,8 @@ private:
 
 	Solution mInitialSolution;
 	MachinesProcessesIDs mMachinesInitialProcesses;
+	std::vector<std::vector<ServiceID>> mServicesDependingServices;
+	std::vector<std::vector<MachineID>> mLocationsMachinesIDs;
 
 	Solution mSolution;
 };
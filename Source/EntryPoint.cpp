@@ -3,24 +3,97 @@
 #include "Checker/FullChecker.hpp"
 #include "Solver/Solver.hpp"
 
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
 int main(int argc, char **argv)
 {
 	// Initialise loggers
 	Log::init();
 
     // Check arguments
-	if (argc != 5)
+	if (argc < 5)
 	{
-		APP_INFO("Usage for solver: ./ReallocationChallenge solve <instance filepath> <initial assignment filepath> <output file filepath>");
+		APP_INFO("Usage for solver: ./ReallocationChallenge solve <instance filepath> <initial assignment filepath> <output file filepath> [options]");
+		APP_INFO("Solver options:");
+		APP_INFO("\t--drain <machine IDs separated by commas>: empties these machines first, and keeps them empty");
+		APP_INFO("\t--search <descent|randomised|annealing|tabu|lahc|vns|ils|alns>: search driver, descent by default");
+		APP_INFO("\t--seed <unsigned integer>: seed of the randomised searches, 0 by default");
+		APP_INFO("\t--temperature <number>: initial temperature of the annealing, calibrated from sampled moves by default");
+		APP_INFO("\t--history <integer>: length of the cost history of the late acceptance, scaled with the number of processes by default");
+		APP_INFO("\t--threshold <fraction>: the iterated local search accepts solutions up to this fraction above the best cost, 0 by default");
 		APP_INFO("Usage for checker: ./ReallocationChallenge check <instance filepath> <initial assignment filepath> <new assignment filepath>");
+		APP_INFO("Usage for delta evaluation test: ./ReallocationChallenge test <instance filepath> <initial assignment filepath> <number of moves>");
 		return 0;
 	}
 
 	if (strcmp(argv[1], "solve") == 0)
 	{
+		SolverOptions options;
+		for (int argID = 5; argID < argc; ++argID)
+		{
+			if (strcmp(argv[argID], "--drain") == 0 && argID + 1 < argc)
+			{
+				std::stringstream machinesIDs(argv[++argID]);
+				std::string machineID;
+				while (std::getline(machinesIDs, machineID, ','))
+				{
+					char* end = nullptr;
+					const long long parsedMachineID = std::strtoll(machineID.c_str(), &end, 10);
+					if (machineID.empty() || *end != '\0')
+						APP_WARN("Invalid machine ID \"{0}\" in --drain, it is ignored.", machineID);
+					else
+						options.drainedMachinesIDs.push_back(parsedMachineID);
+				}
+			}
+			else if (strcmp(argv[argID], "--search") == 0 && argID + 1 < argc)
+			{
+				const char* searchMode = argv[++argID];
+				if (strcmp(searchMode, "descent") == 0)
+					options.searchMode = SearchMode::Descent;
+				else if (strcmp(searchMode, "randomised") == 0)
+					options.searchMode = SearchMode::Randomised;
+				else if (strcmp(searchMode, "annealing") == 0)
+					options.searchMode = SearchMode::Annealing;
+				else if (strcmp(searchMode, "tabu") == 0)
+					options.searchMode = SearchMode::Tabu;
+				else if (strcmp(searchMode, "lahc") == 0)
+					options.searchMode = SearchMode::LateAcceptance;
+				else if (strcmp(searchMode, "vns") == 0)
+					options.searchMode = SearchMode::VariableNeighbourhoods;
+				else if (strcmp(searchMode, "ils") == 0)
+					options.searchMode = SearchMode::IteratedLocalSearch;
+				else if (strcmp(searchMode, "alns") == 0)
+					options.searchMode = SearchMode::AdaptiveLargeNeighbourhoods;
+				else
+					APP_WARN("Unknown search {0}, the descent is used.", searchMode);
+			}
+			else if (strcmp(argv[argID], "--seed") == 0 && argID + 1 < argc)
+			{
+				options.seed = std::strtoull(argv[++argID], nullptr, 10);
+			}
+			else if (strcmp(argv[argID], "--temperature") == 0 && argID + 1 < argc)
+			{
+				options.initialTemperature = std::atof(argv[++argID]);
+			}
+			else if (strcmp(argv[argID], "--history") == 0 && argID + 1 < argc)
+			{
+				options.historyLength = std::atoll(argv[++argID]);
+			}
+			else if (strcmp(argv[argID], "--threshold") == 0 && argID + 1 < argc)
+			{
+				options.acceptanceThreshold = std::atof(argv[++argID]);
+			}
+			else
+			{
+				APP_WARN("Unknown solver option {0}, it is ignored.", argv[argID]);
+			}
+		}
+
 		std::shared_ptr<Data> instance = std::shared_ptr<Data>(new Data(argv[2], argv[3]));
 
-		std::unique_ptr<Solver> solver = std::unique_ptr<Solver>(new Solver());
+		std::unique_ptr<Solver> solver = std::unique_ptr<Solver>(new Solver(options));
 		solver->solveInstance(instance);
 
 		instance->saveNewSolutionToFile(argv[4]);
@@ -42,6 +115,14 @@ int main(int argc, char **argv)
 
 		APP_INFO("Its cost is {0}.", checkerOutput.costs.totalCost);
 	}
+	else if (strcmp(argv[1], "test") == 0)
+	{
+		std::shared_ptr<Data> instance = std::shared_ptr<Data>(new Data(argv[2], argv[3]));
+
+		std::unique_ptr<Solver> solver = std::unique_ptr<Solver>(new Solver());
+		if (!solver->checkDeltaEvaluation(instance, std::atoll(argv[4])))
+			return 1;
+	}
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Core.hpp"
+
+/*
+Zobrist hashing of an assignment: the hash of a solution is the XOR of one 64-bit key per (process, machine) pair.
+Keys are not stored but derived on the fly with a SplitMix64 finaliser, so there is no P x M table to allocate.
+Because XOR is its own inverse, moving a process only costs two key computations, and undoing a move restores the hash.
+*/
+class Zobrist
+{
+public:
+	Zobrist() = delete;
+
+	static inline uint64 getKey(ProcessID processID, MachineID machineID)
+	{
+		uint64 key = (static_cast<uint64>(processID) << 32) + static_cast<uint64>(machineID) + sSeed;
+
+		key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+
+		return key ^ (key >> 31);
+	}
+
+	static inline uint64 getMoveKey(ProcessID processID, MachineID oldMachineID, MachineID newMachineID)
+	{
+		return getKey(processID, oldMachineID) ^ getKey(processID, newMachineID);
+	}
+
+	static inline uint64 calculateSolutionHash(const Solution& solution)
+	{
+		uint64 hash = 0;
+		for (ProcessID processID = 0; processID < static_cast<int64>(solution.size()); ++processID)
+			hash ^= getKey(processID, solution[processID]);
+
+		return hash;
+	}
+
+private:
+	static constexpr uint64 sSeed = 0x9E3779B97F4A7C15ULL;
+};
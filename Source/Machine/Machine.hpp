@@ -13,6 +13,11 @@ public:
 	inline int64 getSafetyLimit(ResourceID resourceID) const { return mSafetyLimits[resourceID]; }
 	inline int64 getMoveCost(MachineID machineID) const { return mMoveCosts[machineID]; }
 
+	inline const std::vector<int64>& getCapacities() const { return mCapacities; }
+	inline const std::vector<int64>& getSafetyLimits() const { return mSafetyLimits; }
+
+	inline void padResources(int64 nbPaddedResources) { mCapacities.resize(nbPaddedResources, 0); mSafetyLimits.resize(nbPaddedResources, 0); }
+
 	inline int64 getLocation() const { return mLocation; }
 	inline int64 getNeighbourhood() const { return mNeighbourhood; }
 
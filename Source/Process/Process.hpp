@@ -14,6 +14,9 @@ public:
 	inline int64 getService() const { return mService; }
 	inline int64 getMoveCost() const { return mMoveCost; }
 	inline int64 getResourceRequirement(ResourceID resourceID) const { return mRequirements[resourceID]; }
+	inline const std::vector<int64>& getRequirements() const { return mRequirements; }
+
+	inline void padResources(int64 nbPaddedResources) { mRequirements.resize(nbPaddedResources, 0); }
 
 private:
 	ServiceID mService;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <utility>
+#include <vector>
+
+/*
+Binary max-heap over the items 0 to n - 1, each with an int64 key.
+The position of every item in the heap is stored, so that the key of any item can be changed in O(log n).
+*/
+class IndexedPriorityQueue
+{
+public:
+	IndexedPriorityQueue() = default;
+	IndexedPriorityQueue(const std::vector<int64>& keys)
+		: mKeys(keys), mHeap(keys.size()), mPositions(keys.size())
+	{
+		for (int64 itemID = 0; itemID < static_cast<int64>(keys.size()); ++itemID)
+		{
+			mHeap[itemID] = itemID;
+			mPositions[itemID] = itemID;
+		}
+
+		for (int64 position = static_cast<int64>(mHeap.size()) / 2 - 1; position >= 0; --position)
+			siftDown(position);
+	}
+
+	inline int64 getSize() const { return mHeap.size(); }
+	inline bool isEmpty() const { return mHeap.empty(); }
+
+	inline int64 getTop() const { return mHeap[0]; }
+	inline int64 getKey(int64 itemID) const { return mKeys[itemID]; }
+
+	void update(int64 itemID, int64 key)
+	{
+		const int64 oldKey = mKeys[itemID];
+		mKeys[itemID] = key;
+
+		if (key > oldKey)
+			siftUp(mPositions[itemID]);
+		else if (key < oldKey)
+			siftDown(mPositions[itemID]);
+	}
+
+	void pop()
+	{
+		swapPositions(0, mHeap.size() - 1);
+		mHeap.pop_back();
+
+		if (!mHeap.empty())
+			siftDown(0);
+	}
+
+	// Every item, largest key first, the queue itself is left untouched
+	std::vector<int64> getSortedItems() const
+	{
+		IndexedPriorityQueue queue = *this;
+
+		std::vector<int64> sortedItems;
+		sortedItems.reserve(queue.getSize());
+		while (!queue.isEmpty())
+		{
+			sortedItems.push_back(queue.getTop());
+			queue.pop();
+		}
+
+		return sortedItems;
+	}
+
+private:
+	void siftUp(int64 position)
+	{
+		while (position > 0)
+		{
+			const int64 parentPosition = (position - 1) / 2;
+			if (mKeys[mHeap[parentPosition]] >= mKeys[mHeap[position]])
+				break;
+
+			swapPositions(position, parentPosition);
+			position = parentPosition;
+		}
+	}
+
+	void siftDown(int64 position)
+	{
+		const int64 size = mHeap.size();
+
+		while (true)
+		{
+			int64 largestPosition = position;
+
+			const int64 leftPosition = 2 * position + 1;
+			const int64 rightPosition = 2 * position + 2;
+			if (leftPosition < size && mKeys[mHeap[leftPosition]] > mKeys[mHeap[largestPosition]])
+				largestPosition = leftPosition;
+			if (rightPosition < size && mKeys[mHeap[rightPosition]] > mKeys[mHeap[largestPosition]])
+				largestPosition = rightPosition;
+
+			if (largestPosition == position)
+				break;
+
+			swapPositions(position, largestPosition);
+			position = largestPosition;
+		}
+	}
+
+	void swapPositions(int64 position1, int64 position2)
+	{
+		std::swap(mHeap[position1], mHeap[position2]);
+		mPositions[mHeap[position1]] = position1;
+		mPositions[mHeap[position2]] = position2;
+	}
+
+private:
+	std::vector<int64> mKeys;		// [item]
+	std::vector<int64> mHeap;		// [position] -> item
+	std::vector<int64> mPositions;	// [item] -> position
+};
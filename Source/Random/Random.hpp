@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <utility>
+#include <vector>
+
+/*
+xoshiro256** generator, seeded through SplitMix64 so that close seeds still give unrelated sequences.
+It is several times faster than std::mt19937_64 and its whole state fits in four words, which matters in the inner loops of the searches.
+Draws in a range use Lemire's multiply and shift on the upper 32 bits, whose bias is negligible for the ranges used here.
+*/
+class Random
+{
+public:
+	Random(uint64 seed = 0) { setSeed(seed); }
+
+	inline void setSeed(uint64 seed)
+	{
+		for (uint64& word : mState)
+		{
+			seed += 0x9E3779B97F4A7C15ULL;
+
+			uint64 mixedSeed = seed;
+			mixedSeed = (mixedSeed ^ (mixedSeed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			mixedSeed = (mixedSeed ^ (mixedSeed >> 27)) * 0x94D049BB133111EBULL;
+			word = mixedSeed ^ (mixedSeed >> 31);
+		}
+	}
+
+	inline uint64 getNext()
+	{
+		const uint64 result = rotateLeft(mState[1] * 5, 7) * 9;
+		const uint64 shiftedState = mState[1] << 17;
+
+		mState[2] ^= mState[0];
+		mState[3] ^= mState[1];
+		mState[1] ^= mState[2];
+		mState[0] ^= mState[3];
+		mState[2] ^= shiftedState;
+		mState[3] = rotateLeft(mState[3], 45);
+
+		return result;
+	}
+
+	// Uniform in [0, upperBound), upperBound must be positive and below 2^32
+	inline int64 getInt(int64 upperBound)
+	{
+		return static_cast<int64>(((getNext() >> 32) * static_cast<uint64>(upperBound)) >> 32);
+	}
+
+	// Uniform in [0, 1)
+	inline double getReal()
+	{
+		return static_cast<double>(getNext() >> 11) * 0x1.0p-53;
+	}
+
+	template<typename T>
+	void shuffle(std::vector<T>& items)
+	{
+		for (int64 itemID = static_cast<int64>(items.size()) - 1; itemID > 0; --itemID)
+			std::swap(items[itemID], items[getInt(itemID + 1)]);
+	}
+
+private:
+	static inline uint64 rotateLeft(uint64 word, int shift) { return (word << shift) | (word >> (64 - shift)); }
+
+	uint64 mState[4];
+};
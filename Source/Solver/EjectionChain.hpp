@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Core.hpp"
+#include "Solver/Shift.hpp"
+
+#include <vector>
+
+struct EjectionChain
+{
+	std::vector<Shift> shifts; // The last process overflows its new machine until one of the machine's processes is ejected
+
+	int64 profit;
+	int64 gainEstimate; // Profit of the chain if ejecting cancelled its last machine's load and balance costs, not an upper bound
+
+	// Best-first frontier: the most profitable partial chain is extended first
+	bool operator<(const EjectionChain& other) const { return profit < other.profit; }
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Core.hpp"
+
+// Reassignment of one process to another machine, every other move is a sequence of shifts
+struct Shift
+{
+	ProcessID processID;
+	MachineID machineID;
+};
@@ -3,11 +3,71 @@
 #include "Checker/FullChecker.hpp"
 #include "Log/Log.hpp"
 
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <unordered_set>
 
 constexpr unsigned int sTimeOutMin = 30;
 
+constexpr int64 sMaxEjectionChainLength = 4;
+constexpr int64 sMaxEjectionChainExpansions = 32; // Per process starting a chain
+
+constexpr int64 sMaxRepackedProcesses = 10; // Up to 2^10 assignments per pair of machines
+
+constexpr int64 sMaxServiceBlockSize = 8;
+
+constexpr int64 sNbCandidateMachines = 64;
+constexpr int64 sMaxCandidateMachinesAge = 1024; // In committed shifts
+
+constexpr int64 sAnnealingCalibrationSamples = 1024;
+constexpr double sAnnealingInitialAcceptanceRate = 0.3; // Of a worsening move of average size
+constexpr double sAnnealingFinalTemperatureRatio = 1e-4;
+constexpr int64 sAnnealingReheatPeriod = 1 << 20; // In iterations without a new best solution
+constexpr double sAnnealingReheatRatio = 0.5; // Each reheat starts at this fraction of the previous one's temperature
+
+constexpr int64 sTabuSampleSize = 256; // Moves drawn per iteration
+constexpr int64 sTabuMinTenure = 8;
+constexpr int64 sTabuTableSize = 1 << 20; // A power of 2
+constexpr int64 sTabuRestartPeriod = 1 << 14; // In iterations without a new best solution, before going back to it
+
+constexpr int64 sLateAcceptanceMinHistoryLength = 1000;
+constexpr int64 sLateAcceptanceProcessesPerHistoryEntry = 10; // The default history is longer on larger instances
+
+constexpr int64 sMaxShakeSize = 64; // In moves, the shaking grows by one move after each failure up to this size
+constexpr int64 sShakeAttemptsPerMove = 16;
+
+constexpr int64 sPerturbationSize = 8; // In moves
+constexpr int64 sPerturbedMachines = 16;
+constexpr int64 sLocalSearchRestartPeriod = 32; // In perturbations without a new best solution, before going back to it
+
+constexpr int64 sMinDestroySize = 2; // In processes
+constexpr int64 sMaxDestroySize = 16;
+constexpr int64 sMaxLocationDestroySize = 64;
+constexpr int64 sDestroyAttemptsPerProcess = 8;
+constexpr int64 sRegretInsertions = 3; // Regret between the best insertion and the third best one
+constexpr int64 sRandomisedRepairChoices = 3; // A process goes to one of its three best insertions
+constexpr int64 sOperatorsSegmentLength = 64; // In iterations, between two weights updates
+constexpr double sOperatorsReactionFactor = 0.2;
+constexpr double sMinOperatorWeight = 0.05;
+
+constexpr double sSearchTimeShare = 0.8; // Of the time limit for the annealing, tabu and late acceptance searches, the descent from their best solution gets the rest
+constexpr int64 sSearchClockPeriod = 1024; // In iterations of the randomised searches, between two reads of the clock
+
+constexpr int64 sConstraintChecksTimingPeriod = 64; // In validated moves
+constexpr int64 sConstraintChecksReorderingPeriod = 65536;
+
+constexpr uint64 sDeltaCheckSeed = 2012;
+constexpr int64 sDeltaCheckFullComparisonPeriod = 1024;
+constexpr int64 sDeltaCheckProgressPeriod = 100000;
+constexpr int64 sMaxReportedDeltaErrors = 20;
+
 bool shouldStopCalculating(const std::chrono::steady_clock::time_point& startTime);
+double getElapsedTimeFraction(const std::chrono::steady_clock::time_point& startTime);
 
 void Solver::solveInstance(const std::shared_ptr<Data>& data)
 {
@@ -15,38 +75,57 @@ void Solver::solveInstance(const std::shared_ptr<Data>& data)
 	auto startTime = std::chrono::steady_clock::now();
 	auto currentTime = startTime;
 
-	mData = data;
-	mChecker = std::shared_ptr<MicroChecker>(new MicroChecker(data));
-	mFullChecker = std::shared_ptr<FullChecker>(new FullChecker(data));
+	initialiseState(data);
 
-	mSolution = mData->getInitialSolution();
+	int64 oldCost = getCurrentCosts().totalCost;
 
-	mMachinesResourcesUsage = mData->calculateMachinesResourcesUsage(mSolution);
-	mMachinesProcesses = mData->calculateMachinesProcesses(mSolution);
+	switch (mOptions.searchMode)
+	{
+		case SearchMode::Descent:
+			descend(startTime);
+			break;
 
-	mServicesLocationsSpread = mData->calculateServicesLocationsSpreads(mSolution);
-	mServicesCost = std::vector<int64>(mData->getNbServices(), 0);
+		case SearchMode::Randomised:
+			searchRandomised(startTime);
+			break;
 
-	mServicesSpreads = std::vector<int64>(mData->getNbServices(), 0);
-	for (ServiceID serviceID = 0; serviceID < mData->getNbServices(); ++serviceID)
-	{
-		for (int64 locationID = 0; locationID < mData->getNbLocations(); ++locationID)
-			mServicesSpreads[serviceID] += std::min(1LL, mServicesLocationsSpread[serviceID][locationID]);
+		case SearchMode::Annealing:
+			anneal(startTime);
+			break;
+
+		case SearchMode::Tabu:
+			searchTabu(startTime);
+			break;
+
+		case SearchMode::LateAcceptance:
+			acceptLate(startTime);
+			break;
+
+		case SearchMode::VariableNeighbourhoods:
+			searchVariableNeighbourhoods(startTime);
+			break;
+
+		case SearchMode::IteratedLocalSearch:
+			searchIteratedLocally(startTime);
+			break;
+
+		case SearchMode::AdaptiveLargeNeighbourhoods:
+			searchAdaptiveLargeNeighbourhoods(startTime);
+			break;
 	}
 
-	int64 oldCost = mFullChecker->calculateSolutionCosts(mSolution, mMachinesResourcesUsage).totalCost;
+	currentTime = std::chrono::steady_clock::now();
 
-	while (!shouldStopCalculating(startTime))
+	for (MachineID machineID : mOptions.drainedMachinesIDs)
 	{
-		swapProcessesIntraServices(startTime);
-
-		swapProcessesBruteForceAsBestFit(startTime);
-		//break;
-		currentTime = std::chrono::steady_clock::now();
+		if (mAreMachinesDrained[machineID] && !mMachinesProcesses[machineID].empty())
+			APP_WARN("Machine {0} could not be fully drained, {1} processes are left on it.", machineID, mMachinesProcesses[machineID].size());
 	}
 
 	mData->attachSolution(mSolution);
-	int64 newCost = mFullChecker->calculateSolutionCosts(mSolution, mMachinesResourcesUsage).totalCost;
+	int64 newCost = getCurrentCosts().totalCost;
+
+	logConstraintChecksStatistics();
 
 	APP_INFO("Solved.");
 	APP_INFO("Old solution cost: {0}", oldCost);
@@ -54,331 +133,2894 @@ void Solver::solveInstance(const std::shared_ptr<Data>& data)
 	APP_INFO("\t which is {0}% of the old one.", static_cast<float>(newCost) / static_cast<float>(oldCost) * 100);
 }
 
-bool Solver::isSwapValid(const Swap& swap, const int flags)
+void Solver::descend(const std::chrono::steady_clock::time_point& startTime)
 {
-	const ProcessID& processID1 = swap.processID1;
-	const ProcessID& processID2 = swap.processID2;
+	std::unordered_set<uint64> visitedSolutionsHashes = { mSolutionHash };
+	while (!shouldStopCalculating(startTime))
+	{
+		// Moves made by the other passes may have made room for the processes still on force-drained machines
+		drainForcedMachines();
 
-	const ServiceID& serviceID1 = mData->getServiceID(processID1);
-	const ServiceID& serviceID2 = mData->getServiceID(processID2);
+		const int64 passStartCost = getCurrentCosts().totalCost;
 
-	applySwap(swap);
+		swapProcessesIntraServices(startTime);
 
-	const MachineID& newMachineID1 = mSolution[processID1];
-	const MachineID& newMachineID2 = mSolution[processID2];
+		shiftProcessesAsBestFit(startTime);
 
-	bool loadConstraintRespected = mChecker->checkMachineCapacityConstraints(newMachineID1, mMachinesResourcesUsage[newMachineID1])
-								&& mChecker->checkMachineCapacityConstraints(newMachineID2, mMachinesResourcesUsage[newMachineID2]);
-	if (!loadConstraintRespected)
-	{
-		applySwap(swap);
-		return false;
-	}
+		swapProcessesBruteForceAsBestFit(startTime);
 
-	bool conflictConstraintRespected = true;
-	if (!(flags & SwapFlag::IntraService))
-	{
-		conflictConstraintRespected = mChecker->checkSwapConflictConstraints(mSolution, swap);
+		// The compound moves are much slower to go through, they are only worth it once the simple ones stall
+		if (getCurrentCosts().totalCost == passStartCost)
+			applyCompoundMoves(startTime);
+
+		APP_TRACE("Pass done, solution cost: {0}", getCurrentCosts().totalCost);
+
+		// Every pass is deterministic, so coming back to an already visited solution means we would loop forever
+		if (!visitedSolutionsHashes.insert(mSolutionHash).second)
+		{
+			APP_INFO("Search came back to an already visited solution.");
+			break;
+		}
 	}
+}
+
+void Solver::searchRandomised(const std::chrono::steady_clock::time_point& startTime)
+{
+	APP_INFO("Randomised search, seed {0}.", mOptions.seed);
 
-	if (!conflictConstraintRespected)
+	while (!shouldStopCalculating(startTime))
 	{
-		applySwap(swap);
-		return false;
+		drainForcedMachines();
+
+		const int64 passStartCost = getCurrentCosts().totalCost;
+
+		moveProcessesAsFirstFit(startTime);
+
+		if (getCurrentCosts().totalCost == passStartCost)
+			applyCompoundMoves(startTime);
+
+		APP_TRACE("Pass done, solution cost: {0}", getCurrentCosts().totalCost);
+
+		// Only strictly improving moves are made, so a pass without any means a local optimum
+		if (getCurrentCosts().totalCost == passStartCost)
+		{
+			APP_INFO("Search reached a local optimum.");
+			break;
+		}
 	}
+}
+
+/*
+The temperature follows the time: it decreases geometrically from the initial one to sAnnealingFinalTemperatureRatio of it
+over sSearchTimeShare of the time limit. After sAnnealingReheatPeriod iterations without a new best solution,
+the schedule starts again over the remaining time, from sAnnealingReheatRatio of the previous cycle's starting temperature.
+A reheat is skipped when that temperature would not be above both the current and the final ones.
+Moves are only checked for feasibility once accepted, most of the worsening ones are turned down from their profit alone.
+*/
+void Solver::anneal(const std::chrono::steady_clock::time_point& startTime)
+{
+	const double initialTemperature = mOptions.initialTemperature > 0.0 ? mOptions.initialTemperature : calibrateTemperature();
+	const double finalTemperature = initialTemperature * sAnnealingFinalTemperatureRatio;
+
+	APP_INFO("Simulated annealing, seed {0}, initial temperature {1:.1f}.", mOptions.seed, initialTemperature);
+
+	resetBestSolution();
+
+	double cycleStartProgress = 0.0;
+	double cycleStartTemperature = initialTemperature;
+	double temperature = initialTemperature;
+	int64 nbReheats = 0;
+	int64 nbIterationsWithoutBest = 0;
 
-	bool spreadConstraintRespected = mServicesSpreads[serviceID1] >= mData->getServiceSpreadMin(serviceID1) && mServicesSpreads[serviceID2] >= mData->getServiceSpreadMin(serviceID2);
-	if (!spreadConstraintRespected)
+	std::vector<Shift> shifts;
+	for (int64 iterationID = 0; ; ++iterationID)
 	{
-		applySwap(swap);
-		return false;
+		if (iterationID % sSearchClockPeriod == 0)
+		{
+			const double progress = getElapsedTimeFraction(startTime) / sSearchTimeShare;
+			if (progress >= 1.0)
+				break;
+
+			if (nbIterationsWithoutBest >= sAnnealingReheatPeriod)
+			{
+				// Only a reheat that actually heats and stays above the final temperature restarts the schedule
+				const double reheatTemperature = cycleStartTemperature * sAnnealingReheatRatio;
+				if (reheatTemperature > temperature && reheatTemperature > finalTemperature)
+				{
+					++nbReheats;
+					cycleStartProgress = progress;
+					cycleStartTemperature = reheatTemperature;
+
+					APP_TRACE("Reheat #{0} at temperature {1:.1f}, best cost: {2}", nbReheats, cycleStartTemperature, mBestCost);
+				}
+
+				nbIterationsWithoutBest = 0;
+			}
+
+			const double cycleProgress = (progress - cycleStartProgress) / (1.0 - cycleStartProgress);
+			temperature = cycleStartTemperature * std::pow(finalTemperature / cycleStartTemperature, cycleProgress);
+		}
+
+		++nbIterationsWithoutBest;
+
+		if (!drawRandomMove(shifts))
+			continue;
+
+		const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+		const bool isAccepted = profit >= 0 || mRandom.getReal() < std::exp(profit / temperature);
+		if (!isAccepted || !isMoveValid(shifts.data(), shifts.size()))
+			continue;
+
+		const int64 bestCost = mBestCost;
+		commitTrackedMove(shifts.data(), shifts.size(), profit);
+		if (mBestCost < bestCost)
+			nbIterationsWithoutBest = 0;
 	}
 
-	bool dependencyConstraintsRespected = mFullChecker->checkDependencyConstraints(mSolution);
-	if (!dependencyConstraintsRespected)
+	restoreBestSolution();
+	APP_INFO("Annealing done, best cost: {0}. Descending from it.", mBestCost);
+
+	descend(startTime);
+}
+
+/*
+Each iteration draws sTabuSampleSize moves and makes the most profitable feasible one, even if it makes the cost worse,
+unless it sends a process back to a machine it recently left. A tabu move is still allowed if it leads to a new best solution.
+The tenure is drawn again at each move between sTabuMinTenure and that plus the square root of the number of processes,
+so that the search does not fall into cycles of a fixed length.
+*/
+void Solver::searchTabu(const std::chrono::steady_clock::time_point& startTime)
+{
+	APP_INFO("Tabu search, seed {0}.", mOptions.seed);
+
+	const int64 tenureRange = static_cast<int64>(std::sqrt(static_cast<double>(mData->getNbProcesses()))) + 1;
+	mTabuExpiryIterations = std::vector<int64>(sTabuTableSize, -1);
+
+	resetBestSolution();
+
+	struct SampledMove
 	{
-		applySwap(swap);
-		return false;
-	}
-	/*auto uncheckedServicesIDs = getDependingServices(serviceID1);
-	for (ServiceID serviceID : uncheckedServicesIDs)
+		Shift shifts[2];
+		int64 nbShifts;
+		int64 profit;
+	};
+
+	std::vector<SampledMove> sampledMoves;
+	std::vector<Shift> shifts;
+	std::vector<MachineID> oldMachinesIDs;
+
+	int64 nbIterationsWithoutBest = 0;
+	for (int64 iterationID = 0; getElapsedTimeFraction(startTime) < sSearchTimeShare; ++iterationID)
 	{
-		bool dependencyConstraintsRespected = mChecker->checkServiceDependencyConstraints(mSolution, serviceID);
-		if (!dependencyConstraintsRespected)
+		// Counted per iteration, those where no sampled move is admissible included
+		++nbIterationsWithoutBest;
+
+		sampledMoves.clear();
+		for (int64 sampleID = 0; sampleID < sTabuSampleSize; ++sampleID)
 		{
-			applySwap(swap);
-			return false;
+			if (!drawRandomMove(shifts))
+				continue;
+
+			SampledMove sampledMove;
+			std::copy(shifts.begin(), shifts.end(), sampledMove.shifts);
+			sampledMove.nbShifts = shifts.size();
+			sampledMove.profit = getMoveProfit(shifts.data(), shifts.size());
+			sampledMoves.push_back(sampledMove);
+		}
+
+		// Feasibility is only checked from the most profitable move down, until one is admissible
+		std::sort(sampledMoves.begin(), sampledMoves.end(), [](const SampledMove& move1, const SampledMove& move2) { return move1.profit > move2.profit; });
+
+		for (const SampledMove& move : sampledMoves)
+		{
+			const bool isAspirated = mTrackedCost - move.profit < mBestCost;
+			if ((!isAspirated && isMoveTabu(move.shifts, move.nbShifts, iterationID)) || !isMoveValid(move.shifts, move.nbShifts))
+				continue;
+
+			oldMachinesIDs.clear();
+			for (int64 shiftID = 0; shiftID < move.nbShifts; ++shiftID)
+				oldMachinesIDs.push_back(mSolution[move.shifts[shiftID].processID]);
+
+			const int64 bestCost = mBestCost;
+			commitTrackedMove(move.shifts, move.nbShifts, move.profit);
+			makeMoveTabu(oldMachinesIDs, move.shifts, move.nbShifts, iterationID + sTabuMinTenure + mRandom.getInt(tenureRange));
+
+			if (mBestCost < bestCost)
+				nbIterationsWithoutBest = 0;
+			break;
+		}
+
+		if (nbIterationsWithoutBest >= sTabuRestartPeriod)
+		{
+			restoreBestSolution();
+			nbIterationsWithoutBest = 0;
+
+			APP_TRACE("Tabu search went back to the best solution, cost: {0}", mBestCost);
 		}
 	}
 
-	uncheckedServicesIDs = getDependingServices(serviceID2);
-	for (ServiceID serviceID : uncheckedServicesIDs)
+	restoreBestSolution();
+	APP_INFO("Tabu search done, best cost: {0}. Descending from it.", mBestCost);
+
+	descend(startTime);
+}
+
+/*
+A move is accepted when the cost it leads to is not worse than the current one, or than the cost the search had L iterations ago.
+The costs of the last L iterations are kept in a circular history. The only parameter is L, the longer it is the slower and deeper the search.
+*/
+void Solver::acceptLate(const std::chrono::steady_clock::time_point& startTime)
+{
+	const int64 historyLength = mOptions.historyLength > 0
+							  ? mOptions.historyLength
+							  : std::max(sLateAcceptanceMinHistoryLength, mData->getNbProcesses() / sLateAcceptanceProcessesPerHistoryEntry);
+
+	APP_INFO("Late acceptance hill climbing, seed {0}, history of {1} costs.", mOptions.seed, historyLength);
+
+	resetBestSolution();
+
+	std::vector<int64> costsHistory(historyLength, mTrackedCost);
+
+	std::vector<Shift> shifts;
+	for (int64 iterationID = 0; ; ++iterationID)
 	{
-		bool dependencyConstraintsRespected = mChecker->checkServiceDependencyConstraints(mSolution, serviceID);
-		if (!dependencyConstraintsRespected)
+		if (iterationID % sSearchClockPeriod == 0 && getElapsedTimeFraction(startTime) >= sSearchTimeShare)
+			break;
+
+		int64& lateCost = costsHistory[iterationID % historyLength];
+
+		if (drawRandomMove(shifts))
 		{
-			applySwap(swap);
-			return false;
+			const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+			const int64 newCost = mTrackedCost - profit;
+
+			if ((newCost <= lateCost || profit >= 0) && isMoveValid(shifts.data(), shifts.size()))
+				commitTrackedMove(shifts.data(), shifts.size(), profit);
 		}
-	}*/
 
-	bool transientConstraintsRespected = mChecker->checkMachineTransientResourcesConstraints(mSolution, newMachineID1, mMachinesResourcesUsage[newMachineID1])
-									  && mChecker->checkMachineTransientResourcesConstraints(mSolution, newMachineID2, mMachinesResourcesUsage[newMachineID2]);
-	if (!transientConstraintsRespected)
-	{
-		applySwap(swap);
-		return false;
+		lateCost = mTrackedCost;
 	}
 
-	applySwap(swap);
+	restoreBestSolution();
+	APP_INFO("Late acceptance done, best cost: {0}. Descending from it.", mBestCost);
 
-	return true;
+	descend(startTime);
 }
 
-void Solver::applySwap(const Swap& swap)
+/*
+Each descent ends in a solution no neighbourhood improves. It is then shaken by k random feasible moves and descended again.
+A better solution is kept and k goes back to 1, otherwise the search goes back to the best solution and k grows.
+*/
+void Solver::searchVariableNeighbourhoods(const std::chrono::steady_clock::time_point& startTime)
 {
-	const ProcessID& processID1 = swap.processID1;
-	const ProcessID& processID2 = swap.processID2;
+	APP_INFO("Variable neighbourhood search, seed {0}.", mOptions.seed);
+
+	initialiseNeighbourhoods();
+	descendVariableNeighbourhoods(startTime);
+
+	// The descents do not track their moves, so the best solution is copied, which only happens when it improves
+	Solution bestSolution = mSolution;
+	int64 bestCost = getCurrentCosts().totalCost;
+
+	int64 shakeSize = 1;
+	while (!shouldStopCalculating(startTime))
+	{
+		shakeSolution(shakeSize);
+		descendVariableNeighbourhoods(startTime);
 
-	const MachineID oldMachineID1 = mSolution[processID1];
-	const MachineID oldMachineID2 = mSolution[processID2];
+		const int64 cost = getCurrentCosts().totalCost;
+		if (cost < bestCost)
+		{
+			bestSolution = mSolution;
+			bestCost = cost;
+			shakeSize = 1;
 
-	const ServiceID serviceID1 = mData->getServiceID(processID1);
-	const ServiceID serviceID2 = mData->getServiceID(processID2);
+			APP_TRACE("New best solution, cost: {0}", cost);
+		}
+		else
+		{
+			restoreSolution(bestSolution);
+			shakeSize = std::min(shakeSize + 1, sMaxShakeSize);
+		}
+	}
 
-	// Swap them
+	for (const Neighbourhood& neighbourhood : mNeighbourhoods)
 	{
-		mSolution[processID1] = oldMachineID2;
-		mSolution[processID2] = oldMachineID1;
+		if (neighbourhood.nbPasses > 0)
+			APP_INFO("\t {0}: {1} passes, {2:.3f} s per pass.", neighbourhood.name, neighbourhood.nbPasses, neighbourhood.totalSeconds / neighbourhood.nbPasses);
 	}
+}
 
-	// Update auxiliary objects
+/*
+Each iteration perturbs the current solution around its most costly machines, then descends through the neighbourhoods.
+The result replaces the current solution if it is not worse, or if it is within the acceptance threshold of the best cost.
+After sLocalSearchRestartPeriod iterations without a new best solution, the search starts again from it.
+*/
+void Solver::searchIteratedLocally(const std::chrono::steady_clock::time_point& startTime)
+{
+	APP_INFO("Iterated local search, seed {0}, acceptance threshold {1}.", mOptions.seed, mOptions.acceptanceThreshold);
+
+	initialiseNeighbourhoods();
+	descendVariableNeighbourhoods(startTime);
+
+	// The descents do not track their moves, so both solutions are copied when they change
+	Solution bestSolution = mSolution;
+	int64 bestCost = getCurrentCosts().totalCost;
+	Solution currentSolution = mSolution;
+	int64 currentCost = bestCost;
+
+	int64 nbIterationsWithoutBest = 0;
+	while (!shouldStopCalculating(startTime))
 	{
-		auto& machineProcesses1 = mMachinesProcesses[oldMachineID1];
-		auto& machineProcesses2 = mMachinesProcesses[oldMachineID2];
+		perturbCostlyMachines(sPerturbationSize);
+		descendVariableNeighbourhoods(startTime);
 
-		machineProcesses1.erase(std::remove(machineProcesses1.begin(), machineProcesses1.end(), processID1), machineProcesses1.end());
-		machineProcesses2.erase(std::remove(machineProcesses2.begin(), machineProcesses2.end(), processID2), machineProcesses2.end());
+		const int64 cost = getCurrentCosts().totalCost;
+		const bool isAccepted = cost <= currentCost || cost <= bestCost + static_cast<int64>(mOptions.acceptanceThreshold * bestCost);
+
+		if (cost < bestCost)
+		{
+			bestSolution = mSolution;
+			bestCost = cost;
+			nbIterationsWithoutBest = 0;
 
-		machineProcesses1.push_back(processID2);
-		machineProcesses2.push_back(processID1);
+			APP_TRACE("New best solution, cost: {0}", cost);
+		}
+		else
+		{
+			++nbIterationsWithoutBest;
+		}
 
-		for (ResourceID resourceID = 0; resourceID < mData->getNbResources(); ++resourceID)
+		if (isAccepted)
 		{
-			mMachinesResourcesUsage[oldMachineID1][resourceID] -= mData->getResourceRequirement(processID1, resourceID);
-			mMachinesResourcesUsage[oldMachineID1][resourceID] += mData->getResourceRequirement(processID2, resourceID);
+			currentSolution = mSolution;
+			currentCost = cost;
+		}
 
-			mMachinesResourcesUsage[oldMachineID2][resourceID] -= mData->getResourceRequirement(processID2, resourceID);
-			mMachinesResourcesUsage[oldMachineID2][resourceID] += mData->getResourceRequirement(processID1, resourceID);
+		if (nbIterationsWithoutBest >= sLocalSearchRestartPeriod)
+		{
+			currentSolution = bestSolution;
+			currentCost = bestCost;
+			nbIterationsWithoutBest = 0;
 		}
+
+		if (mSolution != currentSolution)
+			restoreSolution(currentSolution);
 	}
 
-	const MachineID& newMachineID1 = oldMachineID2;
-	const MachineID& newMachineID2 = oldMachineID1;
+	if (getCurrentCosts().totalCost > bestCost)
+		restoreSolution(bestSolution);
+}
 
-	// Spread
+/*
+Each iteration picks a destroy and a repair operator by roulette wheel over their weights, destroys a few processes and repairs them.
+The iteration ends in the best solution it went through, or in the one it reached if it is as good. A worse one is rolled back.
+Every sOperatorsSegmentLength iterations, the weight of each operator used moves towards its success rate plus its gain per second
+relative to the best gain per second among the operators of its kind.
+*/
+void Solver::searchAdaptiveLargeNeighbourhoods(const std::chrono::steady_clock::time_point& startTime)
+{
+	static const char* sDestroyOperatorsNames[] = { "random", "costly machines", "related services", "neighbourhood", "location" };
+	static const char* sRepairOperatorsNames[] = { "greedy", "regret", "randomised" };
+
+	APP_INFO("Adaptive large neighbourhood search, seed {0}.", mOptions.seed);
+
+	// The operators only touch a few processes, a local optimum is a better place to start from
+	initialiseNeighbourhoods();
+	descendVariableNeighbourhoods(startTime);
+
+	mDestroyOperators = std::vector<SearchOperator>(static_cast<int64>(DestroyOperator::Count));
+	mRepairOperators = std::vector<SearchOperator>(static_cast<int64>(RepairOperator::Count));
+
+	auto selectOperator =
+		[this](const std::vector<SearchOperator>& operators)
+	{
+		double totalWeight = 0.0;
+		for (const SearchOperator& searchOperator : operators)
+			totalWeight += searchOperator.weight;
+
+		double draw = mRandom.getReal() * totalWeight;
+		for (int64 operatorID = 0; operatorID < static_cast<int64>(operators.size()); ++operatorID)
+		{
+			draw -= operators[operatorID].weight;
+			if (draw < 0.0)
+				return operatorID;
+		}
+
+		return static_cast<int64>(operators.size()) - 1;
+	};
+
+	resetBestSolution();
+
+	std::vector<ProcessID> processesIDs;
+	for (int64 iterationID = 1; !shouldStopCalculating(startTime); ++iterationID)
 	{
-		const int64 oldLocationID1 = mData->getMachineLocation(oldMachineID1);
-		const int64 oldLocationID2 = mData->getMachineLocation(oldMachineID2);
+		const int64 destroyOperatorID = selectOperator(mDestroyOperators);
+		const int64 repairOperatorID = selectOperator(mRepairOperators);
 
-		const int64& newLocationID1 = oldLocationID2;
-		const int64& newLocationID2 = oldLocationID1;
+		const auto iterationStartTime = std::chrono::steady_clock::now();
+		const int64 iterationStartCost = mBestCost;
 
-		if (mServicesLocationsSpread[serviceID1][oldLocationID1] == 1)
-			--mServicesSpreads[serviceID1];
-		--mServicesLocationsSpread[serviceID1][oldLocationID1];
+		selectDestroyedProcesses(static_cast<DestroyOperator>(destroyOperatorID), sMinDestroySize + mRandom.getInt(sMaxDestroySize - sMinDestroySize + 1), processesIDs);
+		destroyProcesses(processesIDs);
+		repairProcesses(static_cast<RepairOperator>(repairOperatorID), processesIDs);
 
-		if (mServicesLocationsSpread[serviceID1][newLocationID1] == 0)
-			++mServicesSpreads[serviceID1];
-		++mServicesLocationsSpread[serviceID1][newLocationID1];
+		if (mTrackedCost > mBestCost)
+			restoreBestSolution();
 
-		if (mServicesLocationsSpread[serviceID2][oldLocationID2] == 1)
-			--mServicesSpreads[serviceID2];
-		--mServicesLocationsSpread[serviceID2][oldLocationID2];
+		const int64 gain = iterationStartCost - mTrackedCost;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationStartTime).count();
+		for (SearchOperator* searchOperator : { &mDestroyOperators[destroyOperatorID], &mRepairOperators[repairOperatorID] })
+		{
+			++searchOperator->nbUses;
+			searchOperator->nbSuccesses += gain > 0 ? 1 : 0;
+			searchOperator->gain += gain;
+			searchOperator->seconds += seconds;
+		}
 
-		if (mServicesLocationsSpread[serviceID2][newLocationID2] == 0)
-			++mServicesSpreads[serviceID2];
-		++mServicesLocationsSpread[serviceID2][newLocationID2];
+		if (gain > 0)
+			APP_TRACE("ALNS iteration #{0}, {1} destroy and {2} repair, cost: {3}", iterationID, sDestroyOperatorsNames[destroyOperatorID], sRepairOperatorsNames[repairOperatorID], mTrackedCost);
+
+		if (iterationID % sOperatorsSegmentLength == 0)
+			updateOperatorsWeights();
 	}
 
-	// SMC
+	for (int64 operatorID = 0; operatorID < static_cast<int64>(DestroyOperator::Count); ++operatorID)
 	{
-		const MachineID initialMachineID1 = mData->getProcessInitialAssignment(processID1);
+		const SearchOperator& searchOperator = mDestroyOperators[operatorID];
+		APP_INFO("\t {0} destroy: weight {1:.2f}, {2} uses, total gain {3}.", sDestroyOperatorsNames[operatorID], searchOperator.weight, searchOperator.nbTotalUses + searchOperator.nbUses, searchOperator.totalGain + searchOperator.gain);
+	}
 
-		/*
-		A process is never swapped with another process from the same machine
-		so there's no need to check newMachineID1 == initialMachineID1
-		*/
-		if (oldMachineID1 == initialMachineID1)
-			++mServicesCost[serviceID1];
-	
-		// A process can come back
-		if (oldMachineID1 != initialMachineID1 && newMachineID1 == initialMachineID1)
-			--mServicesCost[serviceID1];
-	
-		// Same for the second process
-		const MachineID initialMachineID2 = mData->getProcessInitialAssignment(processID2);
-		if (oldMachineID2 == initialMachineID2)
-			++mServicesCost[serviceID2];
-	
-		if (oldMachineID2 != initialMachineID2 && newMachineID2 == initialMachineID2)
-			--mServicesCost[serviceID2];
+	for (int64 operatorID = 0; operatorID < static_cast<int64>(RepairOperator::Count); ++operatorID)
+	{
+		const SearchOperator& searchOperator = mRepairOperators[operatorID];
+		APP_INFO("\t {0} repair: weight {1:.2f}, {2} uses, total gain {3}.", sRepairOperatorsNames[operatorID], searchOperator.weight, searchOperator.nbTotalUses + searchOperator.nbUses, searchOperator.totalGain + searchOperator.gain);
 	}
 }
 
-int64 Solver::getSwapProfit(const Swap& swap)
+void Solver::selectDestroyedProcesses(DestroyOperator destroyOperator, int64 nbProcesses, std::vector<ProcessID>& processesIDs)
 {
-	const ProcessID& processID1 = swap.processID1;
-	const ProcessID& processID2 = swap.processID2;
+	processesIDs.clear();
 
-	const MachineID oldMachineID1 = mSolution[processID1];
-	const MachineID oldMachineID2 = mSolution[processID2];
-
-	const int64 oldLoadCost = mChecker->calculateMachineLoadCost(oldMachineID1, mMachinesResourcesUsage)
-					  + mChecker->calculateMachineLoadCost(oldMachineID2, mMachinesResourcesUsage);
-	
-	const int64 oldBalanceCost = mChecker->calculateMachineBalanceCost(oldMachineID1, mMachinesResourcesUsage)
-						 + mChecker->calculateMachineBalanceCost(oldMachineID2, mMachinesResourcesUsage);
+	// Candidates are shuffled and cut to size, except for a location which goes as a whole, up to sMaxLocationDestroySize processes
+	std::vector<ProcessID> candidateProcessesIDs;
+	switch (destroyOperator)
+	{
+		case DestroyOperator::Random:
+		{
+			for (int64 processID = 0; processID < nbProcesses; ++processID)
+				candidateProcessesIDs.push_back(mRandom.getInt(mData->getNbProcesses()));
 
-	int64 oldPMC = 0;
-	if (oldMachineID1 != mData->getProcessInitialAssignment(processID1))
-		oldPMC += mData->getProcessMoveCost(processID1);
+			break;
+		}
 
-	if (oldMachineID2 != mData->getProcessInitialAssignment(processID2))
-		oldPMC += mData->getProcessMoveCost(processID2);
+		case DestroyOperator::CostlyMachines:
+		{
+			std::vector<MachineID> costlyMachinesIDs = getMachinesByCost();
+			if (static_cast<int64>(costlyMachinesIDs.size()) > sPerturbedMachines)
+				costlyMachinesIDs.resize(sPerturbedMachines);
 
-	const int64 oldSMC = *std::max_element(mServicesCost.begin(), mServicesCost.end());
+			for (MachineID machineID : costlyMachinesIDs)
+				candidateProcessesIDs.insert(candidateProcessesIDs.end(), mMachinesProcesses[machineID].begin(), mMachinesProcesses[machineID].end());
 
-	int64 oldMMC = 0;
-	if (oldMachineID1 != mData->getProcessInitialAssignment(processID1))
-		oldMMC += mData->getMachineMoveCost(mData->getProcessInitialAssignment(processID1), mSolution[processID1]);
+			break;
+		}
 
-	if (oldMachineID2 != mData->getProcessInitialAssignment(processID2))
-		oldMMC += mData->getMachineMoveCost(mData->getProcessInitialAssignment(processID2), mSolution[processID2]);
+		// The services of a random process, of its dependencies and of the services depending on it
+		case DestroyOperator::RelatedServices:
+		{
+			const ServiceID serviceID = mData->getServiceID(mRandom.getInt(mData->getNbProcesses()));
 
-	applySwap(swap);
+			std::vector<ServiceID> servicesIDs = { serviceID };
+			servicesIDs.insert(servicesIDs.end(), mData->getServiceDependencies(serviceID).begin(), mData->getServiceDependencies(serviceID).end());
+			servicesIDs.insert(servicesIDs.end(), mData->getServiceDependingServices(serviceID).begin(), mData->getServiceDependingServices(serviceID).end());
 
-	const MachineID newMachineID1 = mSolution[processID1];
-	const MachineID newMachineID2 = mSolution[processID2];
+			for (ServiceID relatedServiceID : servicesIDs)
+			{
+				const auto& serviceProcessesIDs = mData->getServiceProcessesIDs(relatedServiceID);
+				candidateProcessesIDs.insert(candidateProcessesIDs.end(), serviceProcessesIDs.begin(), serviceProcessesIDs.end());
+			}
 
-	const int64 newLoadCost = mChecker->calculateMachineLoadCost(newMachineID1, mMachinesResourcesUsage)
-					  + mChecker->calculateMachineLoadCost(newMachineID2, mMachinesResourcesUsage);
+			break;
+		}
 
-	const int64 newBalanceCost = mChecker->calculateMachineBalanceCost(newMachineID1, mMachinesResourcesUsage)
-						 + mChecker->calculateMachineBalanceCost(newMachineID2, mMachinesResourcesUsage);
+		case DestroyOperator::Neighbourhood:
+		{
+			const NeighbourhoodID neighbourhoodID = mData->getMachineNeighbourhood(mSolution[mRandom.getInt(mData->getNbProcesses())]);
+			for (MachineID machineID = 0; machineID < mData->getNbMachines(); ++machineID)
+			{
+				if (mData->getMachineNeighbourhood(machineID) == neighbourhoodID)
+					candidateProcessesIDs.insert(candidateProcessesIDs.end(), mMachinesProcesses[machineID].begin(), mMachinesProcesses[machineID].end());
+			}
 
-	int64 newPMC = 0;
-	if (newMachineID1 != mData->getProcessInitialAssignment(processID1))
-		newPMC += mData->getProcessMoveCost(processID1);
+			break;
+		}
 
-	if (newMachineID2 != mData->getProcessInitialAssignment(processID2))
-		newPMC += mData->getProcessMoveCost(processID2);
+		case DestroyOperator::Location:
+		{
+			for (MachineID machineID : mData->getLocationMachinesIDs(mRandom.getInt(mData->getNbLocations())))
+				candidateProcessesIDs.insert(candidateProcessesIDs.end(), mMachinesProcesses[machineID].begin(), mMachinesProcesses[machineID].end());
 
-	const int64 newSMC = *std::max_element(mServicesCost.begin(), mServicesCost.end());
-	
-	int64 newMMC = 0;
-	if (newMachineID1 != mData->getProcessInitialAssignment(processID1))
-		newMMC += mData->getMachineMoveCost(mData->getProcessInitialAssignment(processID1), mSolution[processID1]);
+			nbProcesses = sMaxLocationDestroySize;
+			break;
+		}
 
-	if (newMachineID2 != mData->getProcessInitialAssignment(processID2))
-		newMMC += mData->getMachineMoveCost(mData->getProcessInitialAssignment(processID2), mSolution[processID2]);
+		default:
+			break;
+	}
 
-	const int64 loadCostProfit = oldLoadCost - newLoadCost;
-	const int64 balanceCostProfit = oldBalanceCost - newBalanceCost;
-	const int64 PMCProfit = oldPMC - newPMC;
-	const int64 SMCProfit = oldSMC - newSMC;
-	const int64 MMCProfit = oldMMC - newMMC;
+	std::sort(candidateProcessesIDs.begin(), candidateProcessesIDs.end());
+	candidateProcessesIDs.erase(std::unique(candidateProcessesIDs.begin(), candidateProcessesIDs.end()), candidateProcessesIDs.end());
+	mRandom.shuffle(candidateProcessesIDs);
 
-	applySwap(swap);
+	if (static_cast<int64>(candidateProcessesIDs.size()) > nbProcesses)
+		candidateProcessesIDs.resize(nbProcesses);
 
-	return loadCostProfit + balanceCostProfit + PMCProfit + SMCProfit + MMCProfit;
+	processesIDs = candidateProcessesIDs;
 }
 
-void Solver::swapProcessesIntraServices(const std::chrono::steady_clock::time_point & startTime)
+void Solver::destroyProcesses(const std::vector<ProcessID>& processesIDs)
 {
-	for (ProcessID processID1 = 0; processID1 < mData->getNbProcesses(); ++processID1)
+	for (ProcessID processID : processesIDs)
 	{
-		ServiceID serviceID1 = mData->getServiceID(processID1);
-		const auto& serviceProcessesIDs = mData->getServiceProcessesIDs(serviceID1);
+		const auto& candidateMachinesIDs = getCandidateMachines(processID);
+		if (candidateMachinesIDs.empty())
+			continue;
 
-		for (const ProcessID& processID2 : serviceProcessesIDs)
+		// A process that has nowhere else to go stays where it is, it can still be repaired elsewhere once the others have moved
+		for (int64 attemptID = 0; attemptID < sDestroyAttemptsPerProcess; ++attemptID)
 		{
-			// Because we iterate in ascending order, we only have to check for IDs bigger than processID1
-			// In other words, for each swap <x, y>, we have x < y.
-			// Because of this, we also don't need to check if <y, x> is already present in the swap list.
-			if (processID1 <= processID2)
+			const Shift shift = { processID, candidateMachinesIDs[mRandom.getInt(candidateMachinesIDs.size())] };
+			if (!isMachineAllowed(processID, shift.machineID) || !isMoveValid(&shift, 1))
 				continue;
 
-			const Swap swap = { processID1, processID2 };
-
-			if (isSwapValid(swap, SwapFlag::IntraService))
-			{
-				if (getSwapProfit(swap) > 0)
-				{
-					applySwap(swap);
-				}
-			}
-
-			if (shouldStopCalculating(startTime))
-				return;
+			commitTrackedMove(&shift, 1, getMoveProfit(&shift, 1));
+			break;
 		}
 	}
 }
 
-void Solver::swapProcessesBruteForceAsBestFit(const std::chrono::steady_clock::time_point& startTime)
+void Solver::repairProcesses(RepairOperator repairOperator, std::vector<ProcessID> processesIDs)
 {
-	for (ProcessID processID1 = 0; processID1 < mData->getNbProcesses(); ++processID1)
+	std::vector<std::pair<int64, MachineID>> insertions;
+
+	// The largest processes are the hardest to place, they go first
+	auto getSize =
+		[this](ProcessID processID)
 	{
-		int64 bestProfit = 0;
-		ProcessID bestProcessID = INT64_MAX;
-		for (ProcessID processID2 = 0; processID2 < mData->getNbProcesses(); ++processID2)
+		const auto& requirements = mData->getResourceRequirements(processID);
+		return std::accumulate(requirements.begin(), requirements.end(), 0LL);
+	};
+
+	if (repairOperator != RepairOperator::Regret)
+		std::sort(processesIDs.begin(), processesIDs.end(), [&getSize](ProcessID processID1, ProcessID processID2) { return getSize(processID1) > getSize(processID2); });
+
+	while (!processesIDs.empty())
+	{
+		int64 repairedID = 0;
+		MachineID machineID = INT64_MAX;
+		int64 profit = 0;
+
+		switch (repairOperator)
 		{
-			const Swap swap = { processID1, processID2 };
+			case RepairOperator::Greedy:
+			{
+				getBestInsertions(processesIDs[repairedID], 1, insertions);
+				std::tie(profit, machineID) = insertions.front();
+				break;
+			}
 
-			if (isSwapValid(swap))
+			// The process that would lose the most by not getting its best insertion goes first
+			case RepairOperator::Regret:
 			{
-				int64 profit = getSwapProfit(swap);
-				if (profit >= bestProfit)
+				int64 bestRegret = -1;
+				for (int64 processID = 0; processID < static_cast<int64>(processesIDs.size()); ++processID)
 				{
-					bestProfit = profit;
-					bestProcessID = processID2;
+					getBestInsertions(processesIDs[processID], sRegretInsertions, insertions);
+
+					const int64 regret = insertions.front().first - insertions.back().first;
+					if (regret > bestRegret)
+					{
+						bestRegret = regret;
+						repairedID = processID;
+						std::tie(profit, machineID) = insertions.front();
+					}
 				}
+
+				break;
 			}
 
-			if (shouldStopCalculating(startTime))
-				return;
-	}
+			case RepairOperator::Randomised:
+			{
+				getBestInsertions(processesIDs[repairedID], sRandomisedRepairChoices, insertions);
+				std::tie(profit, machineID) = insertions[mRandom.getInt(insertions.size())];
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		const ProcessID processID = processesIDs[repairedID];
+		if (machineID != mSolution[processID])
+		{
+			const Shift shift = { processID, machineID };
+			commitTrackedMove(&shift, 1, profit);
+		}
 
-	if (bestProcessID != INT64_MAX)
-		applySwap({ processID1, bestProcessID });
+		processesIDs.erase(processesIDs.begin() + repairedID);
 	}
 }
 
-std::vector<ServiceID> Solver::getDependingServices(ServiceID serviceID)
+void Solver::getBestInsertions(ProcessID processID, int64 nbInsertions, std::vector<std::pair<int64, MachineID>>& insertions)
 {
-	std::vector<ServiceID> dependingServices;
+	insertions.clear();
+	for (MachineID machineID : getCandidateMachines(processID))
+	{
+		if (!isMachineAllowed(processID, machineID))
+			continue;
+
+		const Shift shift = { processID, machineID };
+		insertions.push_back({ getMoveProfit(&shift, 1), machineID });
+	}
+
+	std::sort(insertions.begin(), insertions.end(), std::greater<std::pair<int64, MachineID>>());
+
+	// Feasibility is only checked from the most profitable insertion down, until enough are found
+	int64 nbFeasibleInsertions = 0;
+	for (int64 insertionID = 0; insertionID < static_cast<int64>(insertions.size()) && nbFeasibleInsertions < nbInsertions; ++insertionID)
+	{
+		const Shift shift = { processID, insertions[insertionID].second };
+		if (isMoveValid(&shift, 1))
+			insertions[nbFeasibleInsertions++] = insertions[insertionID];
+	}
+
+	insertions.resize(nbFeasibleInsertions);
 
-	for (ServiceID serviceID2 = 0; serviceID2 < mData->getNbServices(); ++serviceID2)
+	// Staying where it is, which is always feasible
+	insertions.push_back({ 0, mSolution[processID] });
+	std::sort(insertions.begin(), insertions.end(), std::greater<std::pair<int64, MachineID>>());
+	insertions.resize(std::min(nbInsertions, static_cast<int64>(insertions.size())));
+}
+
+void Solver::updateOperatorsWeights()
+{
+	for (std::vector<SearchOperator>* operators : { &mDestroyOperators, &mRepairOperators })
 	{
-		const auto& serviceDependencies = mData->getServiceDependencies(serviceID2);
+		double bestGainRate = 0.0;
+		for (const SearchOperator& searchOperator : *operators)
+		{
+			if (searchOperator.nbUses > 0 && searchOperator.seconds > 0.0)
+				bestGainRate = std::max(bestGainRate, searchOperator.gain / searchOperator.seconds);
+		}
 
-		for (ServiceID dependencyID : serviceDependencies)
+		for (SearchOperator& searchOperator : *operators)
 		{
-			if (dependencyID == serviceID)
-			{
-				dependingServices.push_back(dependencyID);
-			}
+			if (searchOperator.nbUses == 0)
+				continue;
+
+			const double successRate = static_cast<double>(searchOperator.nbSuccesses) / searchOperator.nbUses;
+			const double relativeGainRate = bestGainRate > 0.0 && searchOperator.seconds > 0.0 ? searchOperator.gain / searchOperator.seconds / bestGainRate : 0.0;
+
+			searchOperator.weight = std::max(sMinOperatorWeight, (1.0 - sOperatorsReactionFactor) * searchOperator.weight + sOperatorsReactionFactor * (successRate + relativeGainRate));
+
+			searchOperator.nbTotalUses += searchOperator.nbUses;
+			searchOperator.totalGain += searchOperator.gain;
+			searchOperator.nbUses = 0;
+			searchOperator.nbSuccesses = 0;
+			searchOperator.gain = 0;
+			searchOperator.seconds = 0.0;
 		}
 	}
-
-	return dependingServices;
 }
 
-bool shouldStopCalculating(const std::chrono::steady_clock::time_point& startTime)
+void Solver::initialiseNeighbourhoods()
 {
-	constexpr std::chrono::duration stopTime = std::chrono::minutes(sTimeOutMin);
-	const auto currentTime = std::chrono::steady_clock::now();
+	// In the order of the descent, which stands until the time per pass of each neighbourhood is known
+	mNeighbourhoods = {
+		{ "intra-service swaps", &Solver::swapProcessesIntraServices },
+		{ "shifts", &Solver::shiftProcessesAsBestFit },
+		{ "swaps", &Solver::swapProcessesBruteForceAsBestFit },
+		{ "double shifts", &Solver::doubleShiftProcesses },
+		{ "cycles", &Solver::cycleProcesses },
+		{ "ejection chains", &Solver::ejectProcesses },
+		{ "repackings", &Solver::repackMachinesPairs },
+		{ "drains", &Solver::drainMachinesAsBestFit },
+		{ "service blocks", &Solver::moveServicesBlocks }
+	};
+}
+
+void Solver::descendVariableNeighbourhoods(const std::chrono::steady_clock::time_point& startTime)
+{
+	auto getSecondsPerPass =
+		[](const Neighbourhood& neighbourhood)
+	{
+		return neighbourhood.nbPasses > 0 ? neighbourhood.totalSeconds / neighbourhood.nbPasses : std::numeric_limits<double>::max();
+	};
+
+	drainForcedMachines();
+
+	int64 neighbourhoodID = 0;
+	while (neighbourhoodID < static_cast<int64>(mNeighbourhoods.size()) && !shouldStopCalculating(startTime))
+	{
+		Neighbourhood& neighbourhood = mNeighbourhoods[neighbourhoodID];
+
+		const int64 passStartCost = getCurrentCosts().totalCost;
+		const auto passStartTime = std::chrono::steady_clock::now();
+
+		(this->*neighbourhood.driver)(startTime);
+
+		++neighbourhood.nbPasses;
+		neighbourhood.totalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - passStartTime).count();
+
+		if (getCurrentCosts().totalCost < passStartCost)
+		{
+			// Back to the cheapest neighbourhood, ranked with the latest measures
+			std::stable_sort(mNeighbourhoods.begin(), mNeighbourhoods.end(),
+				[&getSecondsPerPass](const Neighbourhood& neighbourhood1, const Neighbourhood& neighbourhood2) { return getSecondsPerPass(neighbourhood1) < getSecondsPerPass(neighbourhood2); });
+			neighbourhoodID = 0;
+		}
+		else
+		{
+			++neighbourhoodID;
+		}
+	}
+}
+
+void Solver::shakeSolution(int64 nbMoves)
+{
+	std::vector<Shift> shifts;
+
+	int64 nbCommittedMoves = 0;
+	for (int64 attemptID = 0; attemptID < nbMoves * sShakeAttemptsPerMove && nbCommittedMoves < nbMoves; ++attemptID)
+	{
+		if (!drawRandomMove(shifts) || !isMoveValid(shifts.data(), shifts.size()))
+			continue;
+
+		commitMove(shifts.data(), shifts.size());
+		++nbCommittedMoves;
+	}
+}
+
+void Solver::perturbCostlyMachines(int64 nbMoves)
+{
+	std::vector<MachineID> costlyMachinesIDs = getMachinesByCost();
+	if (static_cast<int64>(costlyMachinesIDs.size()) > sPerturbedMachines)
+		costlyMachinesIDs.resize(sPerturbedMachines);
+
+	int64 nbCommittedMoves = 0;
+	for (int64 attemptID = 0; attemptID < nbMoves * sShakeAttemptsPerMove && nbCommittedMoves < nbMoves; ++attemptID)
+	{
+		const auto& machineProcessesIDs = mMachinesProcesses[costlyMachinesIDs[mRandom.getInt(costlyMachinesIDs.size())]];
+		if (machineProcessesIDs.empty())
+			continue;
+
+		const ProcessID processID = machineProcessesIDs[mRandom.getInt(machineProcessesIDs.size())];
+		const auto& candidateMachinesIDs = getCandidateMachines(processID);
+		if (candidateMachinesIDs.empty())
+			continue;
+
+		const Shift shift = { processID, candidateMachinesIDs[mRandom.getInt(candidateMachinesIDs.size())] };
+		if (!isMachineAllowed(processID, shift.machineID) || !isMoveValid(&shift, 1))
+			continue;
+
+		commitMove(&shift, 1);
+		++nbCommittedMoves;
+	}
+}
+
+bool Solver::isMoveTabu(const Shift* shifts, int64 nbShifts, int64 iterationID) const
+{
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const uint64 key = Zobrist::getKey(shifts[shiftID].processID, shifts[shiftID].machineID);
+		if (mTabuExpiryIterations[key & (sTabuTableSize - 1)] > iterationID)
+			return true;
+	}
+
+	return false;
+}
+
+void Solver::makeMoveTabu(const std::vector<MachineID>& oldMachinesIDs, const Shift* shifts, int64 nbShifts, int64 expiryIterationID)
+{
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const uint64 key = Zobrist::getKey(shifts[shiftID].processID, oldMachinesIDs[shiftID]);
+		mTabuExpiryIterations[key & (sTabuTableSize - 1)] = expiryIterationID;
+	}
+}
+
+bool Solver::drawRandomMove(std::vector<Shift>& shifts)
+{
+	shifts.clear();
+
+	const ProcessID processID1 = mRandom.getInt(mData->getNbProcesses());
+	const MachineID machineID1 = mSolution[processID1];
+
+	const auto& candidateMachinesIDs = getCandidateMachines(processID1);
+	if (candidateMachinesIDs.empty())
+		return false;
+
+	const MachineID machineID2 = candidateMachinesIDs[mRandom.getInt(candidateMachinesIDs.size())];
+	if (!isMachineAllowed(processID1, machineID2))
+		return false;
+
+	shifts.push_back({ processID1, machineID2 });
+
+	// Half of the moves are swaps with one of the processes of the target machine
+	const auto& machineProcessesIDs2 = mMachinesProcesses[machineID2];
+	if (mRandom.getInt(2) == 0 || machineProcessesIDs2.empty())
+		return true;
+
+	const ProcessID processID2 = machineProcessesIDs2[mRandom.getInt(machineProcessesIDs2.size())];
+	if (!isMachineAllowed(processID2, machineID1))
+		return false;
+
+	shifts.push_back({ processID2, machineID1 });
+	return true;
+}
+
+double Solver::calibrateTemperature()
+{
+	std::vector<Shift> shifts;
+
+	int64 nbWorseningMoves = 0;
+	double totalLoss = 0.0;
+	for (int64 sampleID = 0; sampleID < sAnnealingCalibrationSamples; ++sampleID)
+	{
+		if (!drawRandomMove(shifts))
+			continue;
+
+		const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+		if (profit < 0 && isMoveValid(shifts.data(), shifts.size()))
+		{
+			++nbWorseningMoves;
+			totalLoss -= profit;
+		}
+	}
+
+	if (nbWorseningMoves == 0)
+		return 1.0;
+
+	return totalLoss / nbWorseningMoves / -std::log(sAnnealingInitialAcceptanceRate);
+}
+
+void Solver::resetBestSolution()
+{
+	mTrackedCost = getCurrentCosts().totalCost;
+	mBestCost = mTrackedCost;
+	mIsBestSolutionCopied = false;
+	mBestSolutionUndoShifts.clear();
+}
+
+void Solver::commitTrackedMove(const Shift* shifts, int64 nbShifts, int64 profit)
+{
+	if (!mIsBestSolutionCopied)
+	{
+		for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			mBestSolutionUndoShifts.push_back({ shifts[shiftID].processID, mSolution[shifts[shiftID].processID] });
+	}
+
+	commitMove(shifts, nbShifts);
+	mTrackedCost -= profit;
+
+	if (mTrackedCost < mBestCost)
+	{
+		mBestCost = mTrackedCost;
+		mIsBestSolutionCopied = false;
+		mBestSolutionUndoShifts.clear();
+	}
+	else if (!mIsBestSolutionCopied && static_cast<int64>(mBestSolutionUndoShifts.size()) > mData->getNbProcesses())
+	{
+		mBestSolution = mSolution;
+		for (auto shift = mBestSolutionUndoShifts.rbegin(); shift != mBestSolutionUndoShifts.rend(); ++shift)
+			mBestSolution[shift->processID] = shift->machineID;
+
+		mIsBestSolutionCopied = true;
+		mBestSolutionUndoShifts.clear();
+	}
+}
+
+void Solver::restoreBestSolution()
+{
+	if (mIsBestSolutionCopied)
+	{
+		restoreSolution(mBestSolution);
+	}
+	else
+	{
+		// The solutions in between may break every constraint, but commitMove does not check any
+		const std::vector<Shift> shifts(mBestSolutionUndoShifts.rbegin(), mBestSolutionUndoShifts.rend());
+		commitMove(shifts.data(), shifts.size());
+	}
+
+	resetBestSolution();
+}
+
+void Solver::restoreSolution(const Solution& solution)
+{
+	std::vector<Shift> shifts;
+	for (ProcessID processID = 0; processID < mData->getNbProcesses(); ++processID)
+	{
+		if (mSolution[processID] != solution[processID])
+			shifts.push_back({ processID, solution[processID] });
+	}
+
+	commitMove(shifts.data(), shifts.size());
+}
+
+void Solver::applyCompoundMoves(const std::chrono::steady_clock::time_point& startTime)
+{
+	doubleShiftProcesses(startTime);
+
+	cycleProcesses(startTime);
+
+	ejectProcesses(startTime);
+
+	repackMachinesPairs(startTime);
+
+	drainMachinesAsBestFit(startTime);
+
+	moveServicesBlocks(startTime);
+}
+
+bool Solver::checkDeltaEvaluation(const std::shared_ptr<Data>& data, int64 nbMoves)
+{
+	APP_INFO("Checking the delta evaluation against full recalculations on {0} random moves...", nbMoves);
+
+	initialiseState(data);
+
+	std::mt19937_64 randomEngine(sDeltaCheckSeed);
+	std::uniform_int_distribution<ProcessID> processDistribution(0, mData->getNbProcesses() - 1);
+	std::uniform_int_distribution<MachineID> machineDistribution(0, mData->getNbMachines() - 1);
+
+	int64 nbErrors = 0;
+	auto checkMove =
+		[this, &nbErrors](int64 moveID, const std::vector<Shift>& shifts, std::vector<MachineID>& oldMachinesIDs)
+	{
+		const int64 oldCost = mFullChecker->calculateSolutionCosts(mSolution, mMachinesResourcesUsage).totalCost;
+		const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+		const int64 profitBound = getMoveProfitBound(shifts.data(), shifts.size());
+
+		// Committed one shift at a time, to know where to send the processes back
+		oldMachinesIDs.clear();
+		for (const Shift& shift : shifts)
+		{
+			oldMachinesIDs.push_back(mSolution[shift.processID]);
+			commitMove(&shift, 1);
+		}
+
+		const int64 newCost = mFullChecker->calculateSolutionCosts(mSolution, mMachinesResourcesUsage).totalCost;
+		const int64 incrementalCost = getCurrentCosts().totalCost;
+
+		if (oldCost - profit != newCost || incrementalCost != newCost || profitBound < profit || mSolutionHash != Zobrist::calculateSolutionHash(mSolution))
+		{
+			if (nbErrors < sMaxReportedDeltaErrors)
+				APP_ERROR("Move #{0} of {1} shifts: predicted cost {2}, incremental cost {3}, recalculated cost {4}, profit bound {5}.", moveID, shifts.size(), oldCost - profit, incrementalCost, newCost, profitBound);
+
+			++nbErrors;
+		}
+	};
+
+	std::vector<Shift> shifts;
+	std::vector<MachineID> oldMachinesIDs;
+	for (int64 moveID = 0; moveID < nbMoves; ++moveID)
+	{
+		// Alternate shifts, swaps, and chains of shifts that may move the same process twice
+		shifts.clear();
+		switch (moveID % 3)
+		{
+		case 0:
+			shifts.push_back({ processDistribution(randomEngine), machineDistribution(randomEngine) });
+			break;
+
+		case 1:
+		{
+			const ProcessID processID1 = processDistribution(randomEngine);
+			const ProcessID processID2 = processDistribution(randomEngine);
+
+			shifts.push_back({ processID1, mSolution[processID2] });
+			shifts.push_back({ processID2, mSolution[processID1] });
+			break;
+		}
+
+		case 2:
+		{
+			const ProcessID processID1 = processDistribution(randomEngine);
+			const ProcessID processID2 = processDistribution(randomEngine);
+
+			shifts.push_back({ processID1, machineDistribution(randomEngine) });
+			shifts.push_back({ processID2, machineDistribution(randomEngine) });
+			shifts.push_back({ processID1, machineDistribution(randomEngine) });
+			break;
+		}
+		}
+
+		checkMove(moveID, shifts, oldMachinesIDs);
+
+		// Half of the moves are rolled back, so that the search also comes back to already visited states
+		if (randomEngine() % 2 == 0)
+		{
+			std::vector<Shift> rollback;
+			for (int64 shiftID = static_cast<int64>(shifts.size()) - 1; shiftID >= 0; --shiftID)
+				rollback.push_back({ shifts[shiftID].processID, oldMachinesIDs[shiftID] });
+
+			checkMove(moveID, rollback, oldMachinesIDs);
+		}
+
+		// Every auxiliary structure is compared from time to time, it is too slow to do it at each move
+		if (moveID % sDeltaCheckFullComparisonPeriod == 0)
+		{
+			const bool areStructuresValid = mMachinesResourcesUsage == mData->calculateMachinesResourcesUsage(mSolution)
+										 && mServicesLocationsSpread == mData->calculateServicesLocationsSpreads(mSolution)
+										 && mServicesNeighbourhoodsCount == mData->calculateServicesNeighbourhoodsCounts(mSolution)
+										 && mServicesAllowedNeighbourhoodsMasks == calculateAllowedNeighbourhoodsMasks();
+			if (!areStructuresValid)
+			{
+				APP_ERROR("Move #{0}: the incremental structures differ from the recalculated ones.", moveID);
+				++nbErrors;
+			}
+		}
+
+		if (moveID % sDeltaCheckProgressPeriod == 0 && moveID != 0)
+			APP_INFO("{0} moves checked, {1} errors.", moveID, nbErrors);
+	}
+
+	if (nbErrors == 0)
+		APP_INFO("Delta evaluation matches the full recalculation.");
+	else
+		APP_ERROR("Delta evaluation differs from the full recalculation on {0} moves.", nbErrors);
+
+	return nbErrors == 0;
+}
+
+void Solver::initialiseState(const std::shared_ptr<Data>& data)
+{
+	mData = data;
+	mChecker = std::shared_ptr<MicroChecker>(new MicroChecker(data));
+	mFullChecker = std::shared_ptr<FullChecker>(new FullChecker(data));
+
+	mSolution = mData->getInitialSolution();
+	mSolutionHash = Zobrist::calculateSolutionHash(mSolution);
+
+	mMachinesResourcesUsage = mData->calculateMachinesResourcesUsage(mSolution);
+	mMachinesProcesses = mData->calculateMachinesProcesses(mSolution);
+
+	mServicesLocationsSpread = mData->calculateServicesLocationsSpreads(mSolution);
+
+	mServicesSpreads = std::vector<int64>(mData->getNbServices(), 0);
+	for (ServiceID serviceID = 0; serviceID < mData->getNbServices(); ++serviceID)
+	{
+		for (int64 locationID = 0; locationID < mData->getNbLocations(); ++locationID)
+			mServicesSpreads[serviceID] += std::min(1LL, mServicesLocationsSpread[serviceID][locationID]);
+	}
+
+	mServicesNeighbourhoodsCount = mData->calculateServicesNeighbourhoodsCounts(mSolution);
+	initialiseAllowedNeighbourhoods();
+
+	mRandom.setSeed(mOptions.seed);
+
+	mConstraintChecksOrder.clear();
+	for (int64 checkID = 0; checkID < static_cast<int64>(ConstraintCheck::Count); ++checkID)
+		mConstraintChecksOrder.push_back(static_cast<ConstraintCheck>(checkID));
+
+	mConstraintChecksStatistics = std::vector<ConstraintCheckStatistics>(static_cast<int64>(ConstraintCheck::Count));
+	mNbValidatedMoves = 0;
+
+	// Move costs, the solution may not be the initial one
+	mServicesCost = std::vector<int64>(mData->getNbServices(), 0);
+	mProcessMoveCost = 0;
+	mMachineMoveCost = 0;
+	for (ProcessID processID = 0; processID < mData->getNbProcesses(); ++processID)
+	{
+		const MachineID initialMachineID = mData->getProcessInitialAssignment(processID);
+
+		if (mSolution[processID] != initialMachineID)
+		{
+			++mServicesCost[mData->getServiceID(processID)];
+			mProcessMoveCost += mData->getProcessMoveCost(processID);
+		}
+
+		mMachineMoveCost += mData->getMachineMoveCost(initialMachineID, mSolution[processID]);
+	}
+
+	mServicesCostFrequencies = std::vector<int64>(mData->getNbProcesses() + 1, 0);
+	mMaxServiceCost = 0;
+	for (int64 serviceCost : mServicesCost)
+	{
+		++mServicesCostFrequencies[serviceCost];
+		mMaxServiceCost = std::max(mMaxServiceCost, serviceCost);
+	}
+
+	mAreMachinesDrained = std::vector<bool>(mData->getNbMachines(), false);
+	// Invalid IDs are dropped, every later loop over the drained machines indexes the machines' structures with them
+	std::vector<MachineID> drainedMachinesIDs;
+	for (MachineID machineID : mOptions.drainedMachinesIDs)
+	{
+		if (machineID < 0 || machineID >= mData->getNbMachines())
+		{
+			APP_WARN("Machine {0} does not exist, it cannot be drained.", machineID);
+		}
+		else if (!mAreMachinesDrained[machineID])
+		{
+			mAreMachinesDrained[machineID] = true;
+			drainedMachinesIDs.push_back(machineID);
+		}
+	}
+	mOptions.drainedMachinesIDs = drainedMachinesIDs;
+
+	initialiseMachinesCosts();
+	initialiseMachinesHeadrooms();
+	initialiseCandidateMachines();
+	initialiseDontLookBits();
+}
+
+bool Solver::isSwapValid(const Swap& swap, const int flags)
+{
+	const Shift shifts[2] = { { swap.processID1, mSolution[swap.processID2] }, { swap.processID2, mSolution[swap.processID1] } };
+
+	return isMoveValid(shifts, 2, flags);
+}
+
+bool Solver::isMoveValid(const Shift* shifts, int64 nbShifts, const int flags)
+{
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		if (mAreMachinesDrained[shifts[shiftID].machineID])
+			return false;
+	}
+
+	mValidatedMovesOldMachinesIDs.clear();
+	mValidatedMovesOldPositions.clear();
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const ProcessID processID = shifts[shiftID].processID;
+		const auto& oldMachineProcessesIDs = mMachinesProcesses[mSolution[processID]];
+
+		mValidatedMovesOldMachinesIDs.push_back(mSolution[processID]);
+		mValidatedMovesOldPositions.push_back(std::find(oldMachineProcessesIDs.begin(), oldMachineProcessesIDs.end(), processID) - oldMachineProcessesIDs.begin());
+		moveProcess(processID, shifts[shiftID].machineID);
+	}
+
+	const bool isTimed = mNbValidatedMoves % sConstraintChecksTimingPeriod == 0;
+
+	bool isValid = true;
+	for (ConstraintCheck check : mConstraintChecksOrder)
+	{
+		// Intra-service swaps cannot create conflicts
+		if (check == ConstraintCheck::Conflict && (flags & SwapFlag::IntraService))
+			continue;
+
+		ConstraintCheckStatistics& statistics = mConstraintChecksStatistics[static_cast<int64>(check)];
+		++statistics.nbCalls;
+
+		std::chrono::steady_clock::time_point checkStartTime;
+		if (isTimed)
+			checkStartTime = std::chrono::steady_clock::now();
+
+		isValid = isConstraintRespected(check, shifts, nbShifts);
+
+		if (isTimed)
+		{
+			++statistics.nbTimedCalls;
+			statistics.timedNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - checkStartTime).count();
+		}
+
+		if (!isValid)
+		{
+			++statistics.nbRejections;
+			break;
+		}
+	}
+
+	// moveProcess appends to the old machine's list, the process goes back to its position there
+	for (int64 shiftID = nbShifts - 1; shiftID >= 0; --shiftID)
+	{
+		const MachineID oldMachineID = mValidatedMovesOldMachinesIDs[shiftID];
+		if (oldMachineID == shifts[shiftID].machineID)
+			continue;
+
+		moveProcess(shifts[shiftID].processID, oldMachineID);
+
+		auto& oldMachineProcessesIDs = mMachinesProcesses[oldMachineID];
+		std::rotate(oldMachineProcessesIDs.begin() + mValidatedMovesOldPositions[shiftID], oldMachineProcessesIDs.end() - 1, oldMachineProcessesIDs.end());
+	}
+
+	if (++mNbValidatedMoves % sConstraintChecksReorderingPeriod == 0)
+		reorderConstraintChecks();
+
+	return isValid;
+}
+
+// Called by isMoveValid once the shifts are applied
+bool Solver::isConstraintRespected(ConstraintCheck check, const Shift* shifts, int64 nbShifts)
+{
+	switch (check)
+	{
+		case ConstraintCheck::Capacity:
+		{
+			// Only the machines receiving a process can go over their capacities
+			for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			{
+				const MachineID machineID = shifts[shiftID].machineID;
+				if (!mChecker->checkMachineCapacityConstraints(machineID, mMachinesResourcesUsage[machineID]))
+					return false;
+			}
+
+			return true;
+		}
+
+		case ConstraintCheck::Conflict:
+		{
+			for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			{
+				if (!mChecker->checkProcessConflictConstraints(mSolution, shifts[shiftID].processID))
+					return false;
+			}
+
+			return true;
+		}
+
+		case ConstraintCheck::Spread:
+		{
+			for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			{
+				const ServiceID serviceID = mData->getServiceID(shifts[shiftID].processID);
+				if (mServicesSpreads[serviceID] < mData->getServiceSpreadMin(serviceID))
+					return false;
+			}
+
+			return true;
+		}
+
+		/*
+		The solution was valid before the move, so only two things can break a dependency:
+		a process arriving in a neighbourhood without one of its service's dependencies,
+		or the last process of a service leaving a neighbourhood where a depending service still runs.
+		*/
+		case ConstraintCheck::Dependency:
+		{
+			for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			{
+				const ProcessID processID = shifts[shiftID].processID;
+				const ServiceID serviceID = mData->getServiceID(processID);
+
+				const NeighbourhoodID oldNeighbourhoodID = mData->getMachineNeighbourhood(mValidatedMovesOldMachinesIDs[shiftID]);
+				const NeighbourhoodID newNeighbourhoodID = mData->getMachineNeighbourhood(mSolution[processID]);
+				if (oldNeighbourhoodID == newNeighbourhoodID)
+					continue;
+
+				if (!isNeighbourhoodAllowed(serviceID, newNeighbourhoodID))
+					return false;
+
+				if (mServicesNeighbourhoodsCount[serviceID][oldNeighbourhoodID] == 0)
+				{
+					for (ServiceID dependingServiceID : mData->getServiceDependingServices(serviceID))
+					{
+						if (mServicesNeighbourhoodsCount[dependingServiceID][oldNeighbourhoodID] != 0)
+							return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		case ConstraintCheck::Transient:
+		{
+			for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+			{
+				const MachineID machineID = shifts[shiftID].machineID;
+				if (!mChecker->checkMachineTransientResourcesConstraints(mSolution, machineID, mMachinesResourcesUsage[machineID]))
+					return false;
+			}
+
+			return true;
+		}
+
+		default:
+			return true;
+	}
+}
+
+/*
+For independent checks, going by increasing cost over rejection probability minimises the expected cost per candidate.
+Each check only sees the candidates that went through the checks before it, so its rates are conditional ones, which is good enough here.
+Both estimates are smoothed so that a check with few calls is neither put first nor last for good.
+*/
+void Solver::reorderConstraintChecks()
+{
+	auto getExpectedCostPerRejection =
+		[this](ConstraintCheck check)
+	{
+		const ConstraintCheckStatistics& statistics = mConstraintChecksStatistics[static_cast<int64>(check)];
+
+		const double nanosecondsPerCall = static_cast<double>(statistics.timedNanoseconds + 1) / (statistics.nbTimedCalls + 1);
+		const double rejectionRate = static_cast<double>(statistics.nbRejections + 1) / (statistics.nbCalls + 2);
+
+		return nanosecondsPerCall / rejectionRate;
+	};
+
+	std::stable_sort(mConstraintChecksOrder.begin(), mConstraintChecksOrder.end(),
+		[&getExpectedCostPerRejection](ConstraintCheck check1, ConstraintCheck check2) { return getExpectedCostPerRejection(check1) < getExpectedCostPerRejection(check2); });
+}
+
+void Solver::logConstraintChecksStatistics()
+{
+	static const char* sConstraintChecksNames[] = { "Capacity", "Conflict", "Spread", "Dependency", "Transient" };
+
+	APP_INFO("{0} moves validated, constraint checks in their final order:", mNbValidatedMoves);
+	for (ConstraintCheck check : mConstraintChecksOrder)
+	{
+		const ConstraintCheckStatistics& statistics = mConstraintChecksStatistics[static_cast<int64>(check)];
+
+		const double rejectionPercentage = statistics.nbCalls > 0 ? 100.0 * statistics.nbRejections / statistics.nbCalls : 0.0;
+		const int64 nanosecondsPerCall = statistics.nbTimedCalls > 0 ? statistics.timedNanoseconds / statistics.nbTimedCalls : 0;
+
+		APP_INFO("\t {0}: {1} calls, {2} rejections ({3}%), about {4} ns per call.",
+			sConstraintChecksNames[static_cast<int64>(check)], statistics.nbCalls, statistics.nbRejections, rejectionPercentage, nanosecondsPerCall);
+	}
+}
+
+void Solver::commitSwap(const Swap& swap)
+{
+	const Shift shifts[2] = { { swap.processID1, mSolution[swap.processID2] }, { swap.processID2, mSolution[swap.processID1] } };
+
+	commitMove(shifts, 2);
+}
+
+void Solver::commitMove(const Shift* shifts, int64 nbShifts)
+{
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const MachineID oldMachineID = mSolution[shifts[shiftID].processID];
+		const MachineID newMachineID = shifts[shiftID].machineID;
+
+		moveProcess(shifts[shiftID].processID, newMachineID);
+
+		// moveProcess is also used to try moves and roll them back, only a committed move really changes the usages
+		markMachineDirty(oldMachineID);
+		markMachineDirty(newMachineID);
+
+		refreshMachineHeadrooms(oldMachineID);
+		refreshMachineHeadrooms(newMachineID);
+
+		++mNbCommittedShifts;
+		mMachinesChangeStamps[oldMachineID] = mNbCommittedShifts;
+		mMachinesChangeStamps[newMachineID] = mNbCommittedShifts;
+	}
+}
+
+void Solver::moveProcess(ProcessID processID, MachineID newMachineID)
+{
+	const MachineID oldMachineID = mSolution[processID];
+	if (oldMachineID == newMachineID)
+		return;
+
+	const ServiceID serviceID = mData->getServiceID(processID);
+	const MachineID initialMachineID = mData->getProcessInitialAssignment(processID);
+
+	// Move it
+	{
+		mSolution[processID] = newMachineID;
+		mSolutionHash ^= Zobrist::getMoveKey(processID, oldMachineID, newMachineID);
+	}
+
+	// Update auxiliary objects
+	{
+		auto& oldMachineProcesses = mMachinesProcesses[oldMachineID];
+		oldMachineProcesses.erase(std::find(oldMachineProcesses.begin(), oldMachineProcesses.end(), processID));
+		mMachinesProcesses[newMachineID].push_back(processID);
+
+		const Kernels::KernelTable& kernels = mChecker->getKernels();
+		const int64* requirements = mData->getResourceRequirements(processID).data();
+
+		kernels.removeRequirements(mMachinesResourcesUsage[oldMachineID].data(), requirements, kernels.nbResources);
+		kernels.addRequirements(mMachinesResourcesUsage[newMachineID].data(), requirements, kernels.nbResources);
+	}
+
+	// Spread
+	{
+		const int64 oldLocationID = mData->getMachineLocation(oldMachineID);
+		const int64 newLocationID = mData->getMachineLocation(newMachineID);
+
+		if (mServicesLocationsSpread[serviceID][oldLocationID] == 1)
+			--mServicesSpreads[serviceID];
+		--mServicesLocationsSpread[serviceID][oldLocationID];
+
+		if (mServicesLocationsSpread[serviceID][newLocationID] == 0)
+			++mServicesSpreads[serviceID];
+		++mServicesLocationsSpread[serviceID][newLocationID];
+	}
+
+	// Dependencies
+	{
+		const NeighbourhoodID oldNeighbourhoodID = mData->getMachineNeighbourhood(oldMachineID);
+		const NeighbourhoodID newNeighbourhoodID = mData->getMachineNeighbourhood(newMachineID);
+
+		if (--mServicesNeighbourhoodsCount[serviceID][oldNeighbourhoodID] == 0)
+			updateAllowedNeighbourhoods(serviceID, oldNeighbourhoodID, 1);
+
+		if (++mServicesNeighbourhoodsCount[serviceID][newNeighbourhoodID] == 1)
+			updateAllowedNeighbourhoods(serviceID, newNeighbourhoodID, -1);
+	}
+
+	// PMC and SMC
+	{
+		const bool wasMoved = oldMachineID != initialMachineID;
+		const bool isMoved = newMachineID != initialMachineID;
+
+		if (wasMoved != isMoved)
+		{
+			const int64 oldServiceCost = mServicesCost[serviceID];
+			const int64 newServiceCost = isMoved ? oldServiceCost + 1 : oldServiceCost - 1;
+
+			mServicesCost[serviceID] = newServiceCost;
+			--mServicesCostFrequencies[oldServiceCost];
+			++mServicesCostFrequencies[newServiceCost];
+
+			if (newServiceCost > mMaxServiceCost)
+				mMaxServiceCost = newServiceCost;
+			else if (oldServiceCost == mMaxServiceCost && mServicesCostFrequencies[oldServiceCost] == 0)
+				mMaxServiceCost = newServiceCost;
+
+			mProcessMoveCost += isMoved ? mData->getProcessMoveCost(processID) : -mData->getProcessMoveCost(processID);
+		}
+	}
+
+	// MMC
+	mMachineMoveCost += mData->getMachineMoveCost(initialMachineID, newMachineID) - mData->getMachineMoveCost(initialMachineID, oldMachineID);
+}
+
+int64 Solver::getMoveProfit(const Shift* shifts, int64 nbShifts)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+	const int64 nbPaddedResources = mData->getNbPaddedResources();
+
+	mTouchedMachinesIDs.clear();
+	mMovedProcessesIDs.clear();
+	mMovedProcessesMachinesIDs.clear();
+	mChangedServicesIDs.clear();
+	mChangedServicesCosts.clear();
+
+	// Usage of a touched machine once the move is applied, copied from the current one on first touch
+	auto getTouchedMachineResourcesUsage =
+		[this, nbPaddedResources](MachineID machineID)
+	{
+		int64 touchedMachineID = std::find(mTouchedMachinesIDs.begin(), mTouchedMachinesIDs.end(), machineID) - mTouchedMachinesIDs.begin();
+		if (touchedMachineID == static_cast<int64>(mTouchedMachinesIDs.size()))
+		{
+			mTouchedMachinesIDs.push_back(machineID);
+			mTouchedMachinesResourcesUsage.resize(mTouchedMachinesIDs.size() * nbPaddedResources);
+			std::copy(mMachinesResourcesUsage[machineID].begin(), mMachinesResourcesUsage[machineID].end(), mTouchedMachinesResourcesUsage.begin() + touchedMachineID * nbPaddedResources);
+		}
+
+		return mTouchedMachinesResourcesUsage.data() + touchedMachineID * nbPaddedResources;
+	};
+
+	// Usages, and where each process ends up
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const ProcessID processID = shifts[shiftID].processID;
+		const MachineID newMachineID = shifts[shiftID].machineID;
+
+		int64 movedProcessID = std::find(mMovedProcessesIDs.begin(), mMovedProcessesIDs.end(), processID) - mMovedProcessesIDs.begin();
+		if (movedProcessID == static_cast<int64>(mMovedProcessesIDs.size()))
+		{
+			mMovedProcessesIDs.push_back(processID);
+			mMovedProcessesMachinesIDs.push_back(mSolution[processID]);
+		}
+
+		const MachineID oldMachineID = mMovedProcessesMachinesIDs[movedProcessID];
+		if (oldMachineID == newMachineID)
+			continue;
+
+		const int64* requirements = mData->getResourceRequirements(processID).data();
+		kernels.removeRequirements(getTouchedMachineResourcesUsage(oldMachineID), requirements, kernels.nbResources);
+		kernels.addRequirements(getTouchedMachineResourcesUsage(newMachineID), requirements, kernels.nbResources);
+
+		mMovedProcessesMachinesIDs[movedProcessID] = newMachineID;
+	}
+
+	// Load and balance costs, the current ones come from the cache
+	int64 loadCostProfit = 0;
+	int64 balanceCostProfit = 0;
+	for (int64 touchedMachineID = 0; touchedMachineID < static_cast<int64>(mTouchedMachinesIDs.size()); ++touchedMachineID)
+	{
+		const MachineID machineID = mTouchedMachinesIDs[touchedMachineID];
+		const int64* machineResourcesUsage = mTouchedMachinesResourcesUsage.data() + touchedMachineID * nbPaddedResources;
+
+		loadCostProfit += getMachineLoadCost(machineID) - mChecker->calculateMachineLoadCost(machineID, machineResourcesUsage);
+		balanceCostProfit += getMachineBalanceCost(machineID) - mChecker->calculateMachineBalanceCost(machineID, machineResourcesUsage);
+	}
+
+	// Process and machine move costs only depend on where each process ends up
+	int64 PMCProfit = 0;
+	int64 MMCProfit = 0;
+	for (int64 movedProcessID = 0; movedProcessID < static_cast<int64>(mMovedProcessesIDs.size()); ++movedProcessID)
+	{
+		const ProcessID processID = mMovedProcessesIDs[movedProcessID];
+		const MachineID initialMachineID = mData->getProcessInitialAssignment(processID);
+		const MachineID oldMachineID = mSolution[processID];
+		const MachineID newMachineID = mMovedProcessesMachinesIDs[movedProcessID];
+
+		MMCProfit += mData->getMachineMoveCost(initialMachineID, oldMachineID) - mData->getMachineMoveCost(initialMachineID, newMachineID);
+
+		const bool wasMoved = oldMachineID != initialMachineID;
+		const bool isMoved = newMachineID != initialMachineID;
+		if (wasMoved == isMoved)
+			continue;
+
+		PMCProfit += isMoved ? -mData->getProcessMoveCost(processID) : mData->getProcessMoveCost(processID);
+
+		const ServiceID serviceID = mData->getServiceID(processID);
+		int64 changedServiceID = std::find(mChangedServicesIDs.begin(), mChangedServicesIDs.end(), serviceID) - mChangedServicesIDs.begin();
+		if (changedServiceID == static_cast<int64>(mChangedServicesIDs.size()))
+		{
+			mChangedServicesIDs.push_back(serviceID);
+			mChangedServicesCosts.push_back(mServicesCost[serviceID]);
+		}
+
+		mChangedServicesCosts[changedServiceID] += isMoved ? 1 : -1;
+	}
+
+	// SMC: largest cost among the changed services, and among the others thanks to the frequencies
+	int64 newMaxServiceCost = 0;
+	for (int64 serviceCost : mChangedServicesCosts)
+		newMaxServiceCost = std::max(newMaxServiceCost, serviceCost);
+
+	for (int64 serviceCost = mMaxServiceCost; serviceCost > newMaxServiceCost; --serviceCost)
+	{
+		int64 nbUnchangedServices = mServicesCostFrequencies[serviceCost];
+		for (ServiceID serviceID : mChangedServicesIDs)
+		{
+			if (mServicesCost[serviceID] == serviceCost)
+				--nbUnchangedServices;
+		}
+
+		if (nbUnchangedServices > 0)
+		{
+			newMaxServiceCost = serviceCost;
+			break;
+		}
+	}
+
+	const int64 SMCProfit = mMaxServiceCost - newMaxServiceCost;
+
+	return loadCostProfit + balanceCostProfit
+		 + mData->getPMCWeight() * PMCProfit
+		 + mData->getSMCWeight() * SMCProfit
+		 + mData->getMMCWeight() * MMCProfit;
+}
+
+/*
+A machine a process leaves can at best lose its whole load and balance costs, one that only receives processes cannot lower its load cost.
+Process and machine move costs are exact, and the largest service cost drops by at most one per process going back to its initial machine.
+*/
+int64 Solver::getMoveProfitBound(const Shift* shifts, int64 nbShifts)
+{
+	int64 loadAndBalanceCostProfit = 0;
+	int64 moveCostProfit = 0;
+	int64 nbReturningProcesses = 0;
+
+	for (int64 shiftID = 0; shiftID < nbShifts; ++shiftID)
+	{
+		const ProcessID processID = shifts[shiftID].processID;
+		const MachineID oldMachineID = mSolution[processID];
+		const MachineID newMachineID = shifts[shiftID].machineID;
+
+		// Each touched machine is counted once, on its first appearance
+		bool isOldMachineCounted = false;
+		bool isNewMachineCounted = false;
+		bool isNewMachineLeft = false;
+		bool isProcessShiftedAgain = false;
+		for (int64 otherShiftID = 0; otherShiftID < nbShifts; ++otherShiftID)
+		{
+			const MachineID otherOldMachineID = mSolution[shifts[otherShiftID].processID];
+			const MachineID otherNewMachineID = shifts[otherShiftID].machineID;
+
+			if (otherShiftID < shiftID)
+			{
+				isOldMachineCounted |= otherOldMachineID == oldMachineID || otherNewMachineID == oldMachineID;
+				isNewMachineCounted |= otherOldMachineID == newMachineID || otherNewMachineID == newMachineID;
+			}
+			else if (otherShiftID > shiftID)
+			{
+				isProcessShiftedAgain |= shifts[otherShiftID].processID == processID;
+			}
+
+			isNewMachineLeft |= otherOldMachineID == newMachineID;
+		}
+
+		if (!isOldMachineCounted)
+			loadAndBalanceCostProfit += getMachineLoadCost(oldMachineID) + getMachineBalanceCost(oldMachineID);
+
+		// A process shifted again leaves its new machine as well
+		if (!isNewMachineCounted && oldMachineID != newMachineID)
+			loadAndBalanceCostProfit += (isNewMachineLeft || isProcessShiftedAgain ? getMachineLoadCost(newMachineID) : 0) + getMachineBalanceCost(newMachineID);
+
+		// Only the last shift of a process decides where it ends up
+		if (isProcessShiftedAgain)
+			continue;
+
+		const MachineID initialMachineID = mData->getProcessInitialAssignment(processID);
+		moveCostProfit += mData->getMMCWeight() * (mData->getMachineMoveCost(initialMachineID, oldMachineID) - mData->getMachineMoveCost(initialMachineID, newMachineID));
+
+		const bool wasMoved = oldMachineID != initialMachineID;
+		const bool isMoved = newMachineID != initialMachineID;
+		if (wasMoved != isMoved)
+			moveCostProfit += mData->getPMCWeight() * (isMoved ? -mData->getProcessMoveCost(processID) : mData->getProcessMoveCost(processID));
+
+		if (wasMoved && !isMoved)
+			++nbReturningProcesses;
+	}
+
+	return loadAndBalanceCostProfit + moveCostProfit + mData->getSMCWeight() * nbReturningProcesses;
+}
+
+const Costs Solver::getCurrentCosts()
+{
+	refreshDirtyMachinesCosts();
+
+	Costs costs;
+
+	costs.loadCost			= mLoadCost;
+	costs.balanceCost		= mBalanceCost;
+	costs.processMoveCost	= mData->getPMCWeight() * mProcessMoveCost;
+	costs.serviceMoveCost	= mData->getSMCWeight() * mMaxServiceCost;
+	costs.machineMoveCost	= mData->getMMCWeight() * mMachineMoveCost;
+
+	costs.totalCost = costs.loadCost + costs.balanceCost + costs.processMoveCost + costs.serviceMoveCost + costs.machineMoveCost;
+
+	return costs;
+}
+
+void Solver::initialiseMachinesCosts()
+{
+	const int64 nbMachines = mData->getNbMachines();
+
+	mMachinesLoadCost = std::vector<int64>(nbMachines, 0);
+	mMachinesBalanceCost = std::vector<int64>(nbMachines, 0);
+	mAreMachinesDirty = std::vector<bool>(nbMachines, false);
+	mDirtyMachinesIDs.clear();
+
+	mLoadCost = 0;
+	mBalanceCost = 0;
+
+	for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+	{
+		mMachinesLoadCost[machineID] = mChecker->calculateMachineLoadCost(machineID, mMachinesResourcesUsage);
+		mMachinesBalanceCost[machineID] = mChecker->calculateMachineBalanceCost(machineID, mMachinesResourcesUsage);
+
+		mLoadCost += mMachinesLoadCost[machineID];
+		mBalanceCost += mMachinesBalanceCost[machineID];
+	}
+
+	std::vector<int64> machinesCosts(nbMachines, 0);
+	for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+		machinesCosts[machineID] = mMachinesLoadCost[machineID] + mMachinesBalanceCost[machineID];
+
+	mMachinesCostQueue = IndexedPriorityQueue(machinesCosts);
+}
+
+void Solver::markMachineDirty(MachineID machineID)
+{
+	if (mAreMachinesDirty[machineID])
+		return;
+
+	mAreMachinesDirty[machineID] = true;
+	mDirtyMachinesIDs.push_back(machineID);
+}
+
+void Solver::refreshMachineCosts(MachineID machineID)
+{
+	const int64 machineLoadCost = mChecker->calculateMachineLoadCost(machineID, mMachinesResourcesUsage);
+	const int64 machineBalanceCost = mChecker->calculateMachineBalanceCost(machineID, mMachinesResourcesUsage);
+
+	mLoadCost += machineLoadCost - mMachinesLoadCost[machineID];
+	mBalanceCost += machineBalanceCost - mMachinesBalanceCost[machineID];
+
+	mMachinesLoadCost[machineID] = machineLoadCost;
+	mMachinesBalanceCost[machineID] = machineBalanceCost;
+
+	mMachinesCostQueue.update(machineID, machineLoadCost + machineBalanceCost);
+
+	mAreMachinesDirty[machineID] = false;
+}
+
+std::vector<MachineID> Solver::getMachinesByCost()
+{
+	refreshDirtyMachinesCosts();
+
+	return mMachinesCostQueue.getSortedItems();
+}
+
+std::vector<ProcessID> Solver::getProcessesByMachineCost()
+{
+	std::vector<ProcessID> processesIDs;
+	processesIDs.reserve(mData->getNbProcesses());
+
+	for (MachineID machineID : getMachinesByCost())
+		processesIDs.insert(processesIDs.end(), mMachinesProcesses[machineID].begin(), mMachinesProcesses[machineID].end());
+
+	return processesIDs;
+}
+
+int64 Solver::getMachineLoadCost(MachineID machineID)
+{
+	if (mAreMachinesDirty[machineID])
+		refreshMachineCosts(machineID);
+
+	return mMachinesLoadCost[machineID];
+}
+
+int64 Solver::getMachineBalanceCost(MachineID machineID)
+{
+	if (mAreMachinesDirty[machineID])
+		refreshMachineCosts(machineID);
+
+	return mMachinesBalanceCost[machineID];
+}
+
+void Solver::initialiseMachinesHeadrooms()
+{
+	const int64 nbMachines = mData->getNbMachines();
+	const int64 nbPaddedResources = mData->getNbPaddedResources();
+
+	mMachinesFreeCapacities = std::vector<int64>(nbMachines * nbPaddedResources, 0);
+	mMachinesSwapHeadrooms = std::vector<int64>(nbMachines * nbPaddedResources, 0);
+	mFeasibleMachinesMask = std::vector<uint64>((nbMachines + 63) / 64, 0);
+	mChainedFeasibleMachinesMask = std::vector<uint64>((nbMachines + 63) / 64, 0);
+
+	for (MachineID machineID = 0; machineID < nbMachines; ++machineID)
+		refreshMachineHeadrooms(machineID);
+}
+
+void Solver::refreshMachineHeadrooms(MachineID machineID)
+{
+	const int64 nbPaddedResources = mData->getNbPaddedResources();
+
+	const auto& capacities = mData->getResourceCapacities(machineID);
+	const auto& machineResourcesUsage = mMachinesResourcesUsage[machineID];
+
+	int64* freeCapacities = mMachinesFreeCapacities.data() + machineID * nbPaddedResources;
+	int64* swapHeadrooms = mMachinesSwapHeadrooms.data() + machineID * nbPaddedResources;
+
+	for (ResourceID resourceID = 0; resourceID < nbPaddedResources; ++resourceID)
+	{
+		freeCapacities[resourceID] = capacities[resourceID] - machineResourcesUsage[resourceID];
+
+		int64 largestRequirement = 0;
+		for (ProcessID processID : mMachinesProcesses[machineID])
+			largestRequirement = std::max(largestRequirement, mData->getResourceRequirements(processID)[resourceID]);
+
+		swapHeadrooms[resourceID] = freeCapacities[resourceID] + largestRequirement;
+	}
+}
+
+void Solver::initialiseCandidateMachines()
+{
+	mProcessesCandidateMachinesIDs = std::vector<std::vector<MachineID>>(mData->getNbProcesses());
+	mCandidateMachinesStamps = std::vector<int64>(mData->getNbProcesses(), -1);
+	mMachinesChangeStamps = std::vector<int64>(mData->getNbMachines(), 0);
+	mNbCommittedShifts = 0;
+
+	mCandidateMachinesMask = std::vector<uint64>((mData->getNbMachines() + 63) / 64, 0);
+	mCandidateMachineResourcesUsage = std::vector<int64>(mData->getNbPaddedResources(), 0);
+}
+
+const std::vector<MachineID>& Solver::getCandidateMachines(ProcessID processID)
+{
+	if (areCandidateMachinesStale(processID))
+		refreshCandidateMachines(processID);
+
+	return mProcessesCandidateMachinesIDs[processID];
+}
+
+bool Solver::areCandidateMachinesStale(ProcessID processID)
+{
+	const int64 stamp = mCandidateMachinesStamps[processID];
+	if (stamp < 0 || mNbCommittedShifts - stamp > sMaxCandidateMachinesAge || mMachinesChangeStamps[mSolution[processID]] > stamp)
+		return true;
+
+	for (MachineID machineID : mProcessesCandidateMachinesIDs[processID])
+	{
+		if (mMachinesChangeStamps[machineID] > stamp)
+			return true;
+	}
+
+	return false;
+}
+
+void Solver::refreshCandidateMachines(ProcessID processID)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+	const int64* requirements = mData->getResourceRequirements(processID).data();
+
+	const MachineID currentMachineID = mSolution[processID];
+	const MachineID initialMachineID = mData->getProcessInitialAssignment(processID);
+
+	kernels.filterMachines(requirements, mMachinesSwapHeadrooms.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mCandidateMachinesMask.data());
+
+	mCandidateMachinesScores.clear();
+	for (MachineID machineID = 0; machineID < mData->getNbMachines(); ++machineID)
+	{
+		if (machineID == currentMachineID || mAreMachinesDrained[machineID] || !Kernels::isMachineInMask(mCandidateMachinesMask.data(), machineID) || !isMachineAllowed(processID, machineID))
+			continue;
+
+		// Dynamic part: the load and balance costs the process adds to the machine as it is now
+		std::copy(mMachinesResourcesUsage[machineID].begin(), mMachinesResourcesUsage[machineID].end(), mCandidateMachineResourcesUsage.begin());
+		kernels.addRequirements(mCandidateMachineResourcesUsage.data(), requirements, kernels.nbResources);
+
+		const int64 insertionCost = mChecker->calculateMachineLoadCost(machineID, mCandidateMachineResourcesUsage.data()) - getMachineLoadCost(machineID)
+								  + mChecker->calculateMachineBalanceCost(machineID, mCandidateMachineResourcesUsage.data()) - getMachineBalanceCost(machineID);
+
+		// Static part: the move costs of ending up there
+		const int64 moveCost = mData->getMMCWeight() * mData->getMachineMoveCost(initialMachineID, machineID)
+							 + (machineID != initialMachineID ? mData->getPMCWeight() * mData->getProcessMoveCost(processID) : 0);
+
+		mCandidateMachinesScores.push_back({ insertionCost + moveCost, machineID });
+	}
+
+	const int64 nbCandidateMachines = std::min(sNbCandidateMachines, static_cast<int64>(mCandidateMachinesScores.size()));
+	std::partial_sort(mCandidateMachinesScores.begin(), mCandidateMachinesScores.begin() + nbCandidateMachines, mCandidateMachinesScores.end());
+
+	auto& candidateMachinesIDs = mProcessesCandidateMachinesIDs[processID];
+	candidateMachinesIDs.clear();
+	for (int64 candidateID = 0; candidateID < nbCandidateMachines; ++candidateID)
+		candidateMachinesIDs.push_back(mCandidateMachinesScores[candidateID].second);
+
+	mCandidateMachinesStamps[processID] = mNbCommittedShifts;
+}
+
+void Solver::initialiseAllowedNeighbourhoods()
+{
+	mServicesNeighbourhoodsMissingDependencies = ServicesNeighbourhoodsCounts(mData->getNbServices(), std::vector<int64>(mData->getNbNeighbourhoods(), 0));
+	for (ServiceID serviceID = 0; serviceID < mData->getNbServices(); ++serviceID)
+	{
+		for (ServiceID dependencyID : mData->getServiceDependencies(serviceID))
+		{
+			for (NeighbourhoodID neighbourhoodID = 0; neighbourhoodID < mData->getNbNeighbourhoods(); ++neighbourhoodID)
+			{
+				if (mServicesNeighbourhoodsCount[dependencyID][neighbourhoodID] == 0)
+					++mServicesNeighbourhoodsMissingDependencies[serviceID][neighbourhoodID];
+			}
+		}
+	}
+
+	mServicesAllowedNeighbourhoodsMasks = calculateAllowedNeighbourhoodsMasks();
+}
+
+std::vector<std::vector<uint64>> Solver::calculateAllowedNeighbourhoodsMasks() const
+{
+	const int64 nbNeighbourhoods = mData->getNbNeighbourhoods();
+
+	std::vector<std::vector<uint64>> masks(mData->getNbServices(), std::vector<uint64>((nbNeighbourhoods + 63) / 64, 0));
+	for (ServiceID serviceID = 0; serviceID < mData->getNbServices(); ++serviceID)
+	{
+		const auto& serviceDependenciesIDs = mData->getServiceDependencies(serviceID);
+		for (NeighbourhoodID neighbourhoodID = 0; neighbourhoodID < nbNeighbourhoods; ++neighbourhoodID)
+		{
+			const bool isAllowed = std::all_of(serviceDependenciesIDs.begin(), serviceDependenciesIDs.end(),
+				[this, neighbourhoodID](ServiceID dependencyID) { return mServicesNeighbourhoodsCount[dependencyID][neighbourhoodID] > 0; });
+
+			masks[serviceID][neighbourhoodID / 64] |= static_cast<uint64>(isAllowed) << (neighbourhoodID % 64);
+		}
+	}
+
+	return masks;
+}
+
+void Solver::updateAllowedNeighbourhoods(ServiceID dependencyID, NeighbourhoodID neighbourhoodID, int64 nbMissingDependenciesDelta)
+{
+	for (ServiceID dependingServiceID : mData->getServiceDependingServices(dependencyID))
+	{
+		int64& nbMissingDependencies = mServicesNeighbourhoodsMissingDependencies[dependingServiceID][neighbourhoodID];
+		nbMissingDependencies += nbMissingDependenciesDelta;
+
+		uint64& maskWord = mServicesAllowedNeighbourhoodsMasks[dependingServiceID][neighbourhoodID / 64];
+		const uint64 bit = 1ULL << (neighbourhoodID % 64);
+		maskWord = nbMissingDependencies == 0 ? maskWord | bit : maskWord & ~bit;
+	}
+}
+
+void Solver::initialiseDontLookBits()
+{
+	mDontLookStamps = std::vector<std::vector<int64>>(static_cast<int64>(MoveType::Count), std::vector<int64>(mData->getNbProcesses(), -1));
+}
+
+bool Solver::isDontLookBitSet(MoveType moveType, ProcessID processID)
+{
+	// Cleared lazily: the bit only holds if nothing it depends on changed since it was set
+	const int64 stamp = mDontLookStamps[static_cast<int64>(moveType)][processID];
+	if (stamp < 0 || mMachinesChangeStamps[mSolution[processID]] > stamp)
+		return false;
+
+	for (MachineID machineID : mProcessesCandidateMachinesIDs[processID])
+	{
+		if (mMachinesChangeStamps[machineID] > stamp)
+			return false;
+	}
+
+	return true;
+}
+
+void Solver::setDontLookBit(MoveType moveType, ProcessID processID)
+{
+	mDontLookStamps[static_cast<int64>(moveType)][processID] = mNbCommittedShifts;
+}
+
+bool Solver::doesProcessFit(ProcessID processID, MachineID machineID)
+{
+	const int64* requirements = mData->getResourceRequirements(processID).data();
+	const int64* freeCapacities = mMachinesFreeCapacities.data() + machineID * mData->getNbPaddedResources();
+
+	for (ResourceID resourceID = 0; resourceID < mData->getNbResources(); ++resourceID)
+	{
+		if (requirements[resourceID] > freeCapacities[resourceID])
+			return false;
+	}
+
+	return true;
+}
+
+bool Solver::doesProcessFitInstead(ProcessID processID, ProcessID leavingProcessID)
+{
+	const int64* requirements = mData->getResourceRequirements(processID).data();
+	const int64* leavingRequirements = mData->getResourceRequirements(leavingProcessID).data();
+	const int64* freeCapacities = mMachinesFreeCapacities.data() + mSolution[leavingProcessID] * mData->getNbPaddedResources();
+
+	for (ResourceID resourceID = 0; resourceID < mData->getNbResources(); ++resourceID)
+	{
+		if (requirements[resourceID] - leavingRequirements[resourceID] > freeCapacities[resourceID])
+			return false;
+	}
+
+	return true;
+}
+
+bool Solver::isBlockedTarget(ProcessID processID, MachineID machineID)
+{
+	// Where the process fits as it is, moving it there is a single shift
+	return Kernels::isMachineInMask(mFeasibleMachinesMask.data(), machineID) && isMachineAllowed(processID, machineID) && !doesProcessFit(processID, machineID);
+}
+
+void Solver::refreshDirtyMachinesCosts()
+{
+	for (MachineID machineID : mDirtyMachinesIDs)
+	{
+		if (mAreMachinesDirty[machineID])
+			refreshMachineCosts(machineID);
+	}
+
+	mDirtyMachinesIDs.clear();
+}
+
+int64 Solver::getSwapProfit(const Swap& swap)
+{
+	const Shift shifts[2] = { { swap.processID1, mSolution[swap.processID2] }, { swap.processID2, mSolution[swap.processID1] } };
+
+	return getMoveProfit(shifts, 2);
+}
+
+int64 Solver::getSwapProfitBound(const Swap& swap)
+{
+	const Shift shifts[2] = { { swap.processID1, mSolution[swap.processID2] }, { swap.processID2, mSolution[swap.processID1] } };
+
+	return getMoveProfitBound(shifts, 2);
+}
+
+void Solver::swapProcessesIntraServices(const std::chrono::steady_clock::time_point & startTime)
+{
+	for (ProcessID processID1 = 0; processID1 < mData->getNbProcesses(); ++processID1)
+	{
+		ServiceID serviceID1 = mData->getServiceID(processID1);
+		const auto& serviceProcessesIDs = mData->getServiceProcessesIDs(serviceID1);
+
+		for (const ProcessID& processID2 : serviceProcessesIDs)
+		{
+			// Because we iterate in ascending order, we only have to check for IDs bigger than processID1
+			// In other words, for each swap <x, y>, we have x < y.
+			// Because of this, we also don't need to check if <y, x> is already present in the swap list.
+			if (processID1 <= processID2)
+				continue;
+
+			const Swap swap = { processID1, processID2 };
+
+			if (getSwapProfitBound(swap) > 0 && getSwapProfit(swap) > 0)
+			{
+				if (isSwapValid(swap, SwapFlag::IntraService))
+				{
+					commitSwap(swap);
+				}
+			}
+
+			if (shouldStopCalculating(startTime))
+				return;
+		}
+	}
+}
+
+void Solver::swapProcessesBruteForceAsBestFit(const std::chrono::steady_clock::time_point& startTime)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+
+	for (ProcessID processID1 : getProcessesByMachineCost())
+	{
+		if (isDontLookBitSet(MoveType::Swap, processID1))
+			continue;
+
+		// Swapping processID1 onto a machine can at best free the largest requirement there, skip the machines where even that is not enough
+		kernels.filterMachines(mData->getResourceRequirements(processID1).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mFeasibleMachinesMask.data());
+
+		int64 bestProfit = 0;
+		ProcessID bestProcessID = INT64_MAX;
+		for (MachineID machineID2 : getCandidateMachines(processID1))
+		{
+			// Candidate lists can be older than the last dependency changes
+			if (!Kernels::isMachineInMask(mFeasibleMachinesMask.data(), machineID2) || !isMachineAllowed(processID1, machineID2))
+				continue;
+
+			const auto& machineProcessesIDs2 = mMachinesProcesses[machineID2];
+			for (int64 processIndex2 = 0; processIndex2 < static_cast<int64>(machineProcessesIDs2.size()); ++processIndex2)
+			{
+				const ProcessID processID2 = machineProcessesIDs2[processIndex2];
+				if (!isMachineAllowed(processID2, mSolution[processID1]))
+					continue;
+
+				const Swap swap = { processID1, processID2 };
+
+				// Most swaps cannot beat the best one, the feasibility checks are left for those that do
+				if (getSwapProfitBound(swap) < bestProfit)
+					continue;
+
+				const int64 profit = getSwapProfit(swap);
+				if (profit >= bestProfit && isSwapValid(swap))
+				{
+					bestProfit = profit;
+					bestProcessID = processID2;
+				}
+			}
+
+			if (shouldStopCalculating(startTime))
+				return;
+		}
+
+		if (bestProcessID != INT64_MAX)
+			commitSwap({ processID1, bestProcessID });
+
+		// Swaps that do not change the cost are still made, but they do not count as improvements
+		if (bestProfit == 0)
+			setDontLookBit(MoveType::Swap, processID1);
+	}
+}
+
+void Solver::shiftProcessesAsBestFit(const std::chrono::steady_clock::time_point& startTime)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+
+	for (ProcessID processID : getProcessesByMachineCost())
+	{
+		if (isDontLookBitSet(MoveType::Shift, processID))
+			continue;
+
+		kernels.filterMachines(mData->getResourceRequirements(processID).data(), mMachinesFreeCapacities.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mFeasibleMachinesMask.data());
+
+		int64 bestProfit = 0;
+		MachineID bestMachineID = INT64_MAX;
+		for (MachineID machineID : getCandidateMachines(processID))
+		{
+			if (!Kernels::isMachineInMask(mFeasibleMachinesMask.data(), machineID) || !isMachineAllowed(processID, machineID))
+				continue;
+
+			const Shift shift = { processID, machineID };
+			if (getMoveProfitBound(&shift, 1) <= bestProfit)
+				continue;
+
+			const int64 profit = getMoveProfit(&shift, 1);
+			if (profit > bestProfit && isMoveValid(&shift, 1))
+			{
+				bestProfit = profit;
+				bestMachineID = machineID;
+			}
+		}
+
+		if (bestMachineID != INT64_MAX)
+		{
+			const Shift shift = { processID, bestMachineID };
+			commitMove(&shift, 1);
+		}
+		else
+		{
+			setDontLookBit(MoveType::Shift, processID);
+		}
+
+		if (shouldStopCalculating(startTime))
+			return;
+	}
+}
+
+/*
+Processes are taken in a shuffled order, and each one goes through its candidate machines in a shuffled order as well.
+The first shift onto a machine that improves the cost is made, and failing that the first improving swap with one of its processes.
+*/
+void Solver::moveProcessesAsFirstFit(const std::chrono::steady_clock::time_point& startTime)
+{
+	std::vector<ProcessID> processesIDs(mData->getNbProcesses());
+	std::iota(processesIDs.begin(), processesIDs.end(), 0);
+	mRandom.shuffle(processesIDs);
+
+	std::vector<MachineID> machinesIDs;
+
+	for (ProcessID processID1 : processesIDs)
+	{
+		const bool canShift = !isDontLookBitSet(MoveType::Shift, processID1);
+		const bool canSwap = !isDontLookBitSet(MoveType::Swap, processID1);
+		if (!canShift && !canSwap)
+			continue;
+
+		const MachineID machineID1 = mSolution[processID1];
+
+		machinesIDs = getCandidateMachines(processID1);
+		mRandom.shuffle(machinesIDs);
+
+		bool isCommitted = false;
+		for (MachineID machineID2 : machinesIDs)
+		{
+			if (!isMachineAllowed(processID1, machineID2))
+				continue;
+
+			const Shift shift = { processID1, machineID2 };
+			if (canShift && getMoveProfitBound(&shift, 1) > 0 && getMoveProfit(&shift, 1) > 0 && isMoveValid(&shift, 1))
+			{
+				commitMove(&shift, 1);
+				isCommitted = true;
+				break;
+			}
+
+			if (!canSwap)
+				continue;
+
+			// The order of a machine's list does not matter, it is shuffled in place
+			auto& machineProcessesIDs2 = mMachinesProcesses[machineID2];
+			mRandom.shuffle(machineProcessesIDs2);
+
+			for (int64 processIndex2 = 0; processIndex2 < static_cast<int64>(machineProcessesIDs2.size()); ++processIndex2)
+			{
+				const ProcessID processID2 = machineProcessesIDs2[processIndex2];
+				if (!isMachineAllowed(processID2, machineID1))
+					continue;
+
+				const Swap swap = { processID1, processID2 };
+				if (getSwapProfitBound(swap) > 0 && getSwapProfit(swap) > 0 && isSwapValid(swap))
+				{
+					commitSwap(swap);
+					isCommitted = true;
+					break;
+				}
+			}
+
+			if (isCommitted)
+				break;
+		}
+
+		if (!isCommitted)
+		{
+			setDontLookBit(MoveType::Shift, processID1);
+			setDontLookBit(MoveType::Swap, processID1);
+		}
+
+		if (shouldStopCalculating(startTime))
+			return;
+	}
+}
+
+void Solver::doubleShiftProcesses(const std::chrono::steady_clock::time_point& startTime)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+
+	for (ProcessID processID1 : getProcessesByMachineCost())
+	{
+		if (isDontLookBitSet(MoveType::DoubleShift, processID1))
+			continue;
+
+		const MachineID machineID1 = mSolution[processID1];
+
+		kernels.filterMachines(mData->getResourceRequirements(processID1).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mFeasibleMachinesMask.data());
+
+		bool isCommitted = false;
+		for (MachineID machineID2 : getCandidateMachines(processID1))
+		{
+			if (!isBlockedTarget(processID1, machineID2))
+				continue;
+
+			const auto& machineProcessesIDs2 = mMachinesProcesses[machineID2];
+			for (int64 processIndex2 = 0; processIndex2 < static_cast<int64>(machineProcessesIDs2.size()); ++processIndex2)
+			{
+				const ProcessID processID2 = machineProcessesIDs2[processIndex2];
+
+				// Only the processes whose departure makes room for processID1
+				if (!doesProcessFitInstead(processID1, processID2))
+					continue;
+
+				kernels.filterMachines(mData->getResourceRequirements(processID2).data(), mMachinesFreeCapacities.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mChainedFeasibleMachinesMask.data());
+
+				for (MachineID machineID3 : getCandidateMachines(processID2))
+				{
+					// Sending processID2 back to machineID1 would be a swap
+					if (machineID3 == machineID1 || machineID3 == machineID2 || !Kernels::isMachineInMask(mChainedFeasibleMachinesMask.data(), machineID3) || !isMachineAllowed(processID2, machineID3))
+						continue;
+
+					const Shift shifts[2] = { { processID1, machineID2 }, { processID2, machineID3 } };
+
+					if (getMoveProfitBound(shifts, 2) > 0 && getMoveProfit(shifts, 2) > 0 && isMoveValid(shifts, 2))
+					{
+						commitMove(shifts, 2);
+						isCommitted = true;
+						break;
+					}
+				}
+
+				if (isCommitted)
+					break;
+			}
+
+			if (isCommitted)
+				break;
+
+			// A single process can go through many machines and their processes
+			if (shouldStopCalculating(startTime))
+				return;
+		}
+
+		if (!isCommitted)
+			setDontLookBit(MoveType::DoubleShift, processID1);
+	}
+}
+
+void Solver::cycleProcesses(const std::chrono::steady_clock::time_point& startTime)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+
+	for (ProcessID processID1 : getProcessesByMachineCost())
+	{
+		if (isDontLookBitSet(MoveType::Cycle, processID1))
+			continue;
+
+		const MachineID machineID1 = mSolution[processID1];
+
+		kernels.filterMachines(mData->getResourceRequirements(processID1).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mFeasibleMachinesMask.data());
+
+		bool isCommitted = false;
+		for (MachineID machineID2 : getCandidateMachines(processID1))
+		{
+			if (!isBlockedTarget(processID1, machineID2))
+				continue;
+
+			const auto& machineProcessesIDs2 = mMachinesProcesses[machineID2];
+			for (int64 processIndex2 = 0; processIndex2 < static_cast<int64>(machineProcessesIDs2.size()); ++processIndex2)
+			{
+				const ProcessID processID2 = machineProcessesIDs2[processIndex2];
+				if (!doesProcessFitInstead(processID1, processID2))
+					continue;
+
+				kernels.filterMachines(mData->getResourceRequirements(processID2).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mChainedFeasibleMachinesMask.data());
+
+				for (MachineID machineID3 : getCandidateMachines(processID2))
+				{
+					if (machineID3 == machineID1 || machineID3 == machineID2 || !Kernels::isMachineInMask(mChainedFeasibleMachinesMask.data(), machineID3) || !isMachineAllowed(processID2, machineID3))
+						continue;
+
+					const auto& machineProcessesIDs3 = mMachinesProcesses[machineID3];
+					for (int64 processIndex3 = 0; processIndex3 < static_cast<int64>(machineProcessesIDs3.size()); ++processIndex3)
+					{
+						const ProcessID processID3 = machineProcessesIDs3[processIndex3];
+
+						// processID3 closes the cycle by taking the place processID1 left
+						if (!isMachineAllowed(processID3, machineID1) || !doesProcessFitInstead(processID2, processID3) || !doesProcessFitInstead(processID3, processID1))
+							continue;
+
+						const Shift shifts[3] = { { processID1, machineID2 }, { processID2, machineID3 }, { processID3, machineID1 } };
+
+						if (getMoveProfitBound(shifts, 3) > 0 && getMoveProfit(shifts, 3) > 0 && isMoveValid(shifts, 3))
+						{
+							commitMove(shifts, 3);
+							isCommitted = true;
+							break;
+						}
+					}
+
+					if (isCommitted)
+						break;
+				}
+
+				if (isCommitted)
+					break;
+			}
+
+			if (isCommitted)
+				break;
+
+			if (shouldStopCalculating(startTime))
+				return;
+		}
+
+		if (!isCommitted)
+			setDontLookBit(MoveType::Cycle, processID1);
+	}
+}
+
+/*
+A chain moves a process onto a machine where it does not fit, ejects from that machine a process whose departure makes room,
+moves it onto another machine, and so on until the last ejected process fits where it goes, or takes the first process's place.
+Partial chains are extended best-first, as long as their gain estimate can still beat the best complete chain.
+The estimate ignores the move costs refunded to ejected processes going back to their initial machines
+and the balance costs the ejected processes can lower where they go, so this pruning is a heuristic that can miss improving chains.
+*/
+void Solver::ejectProcesses(const std::chrono::steady_clock::time_point& startTime)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+	const int64 nbPaddedResources = mData->getNbPaddedResources();
+
+	std::vector<int64> lastMachineResourcesUsage(nbPaddedResources, 0);
+	std::vector<Shift> candidateShifts;
+	std::vector<Shift> bestShifts;
+
+	for (ProcessID processID0 : getProcessesByMachineCost())
+	{
+		if (isDontLookBitSet(MoveType::EjectionChain, processID0))
+			continue;
+
+		const MachineID machineID0 = mSolution[processID0];
+
+		std::priority_queue<EjectionChain> frontier;
+		int64 bestProfit = 0;
+		bestShifts.clear();
+
+		// Machines of a chain are all distinct, so the last one only gained the last process
+		auto pushChain =
+			[&](const std::vector<Shift>& shifts)
+		{
+			const Shift& lastShift = shifts.back();
+
+			std::copy(mMachinesResourcesUsage[lastShift.machineID].begin(), mMachinesResourcesUsage[lastShift.machineID].end(), lastMachineResourcesUsage.begin());
+			kernels.addRequirements(lastMachineResourcesUsage.data(), mData->getResourceRequirements(lastShift.processID).data(), kernels.nbResources);
+
+			EjectionChain chain;
+			chain.profit = getMoveProfit(shifts.data(), shifts.size());
+			chain.gainEstimate = chain.profit
+							+ mChecker->calculateMachineLoadCost(lastShift.machineID, lastMachineResourcesUsage.data())
+							+ mChecker->calculateMachineBalanceCost(lastShift.machineID, lastMachineResourcesUsage.data());
+
+			if (chain.gainEstimate <= bestProfit)
+				return;
+
+			chain.shifts = shifts;
+			frontier.push(std::move(chain));
+		};
+
+		auto tryCompleteChain =
+			[&](const std::vector<Shift>& shifts)
+		{
+			const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+			if (profit > bestProfit && isMoveValid(shifts.data(), shifts.size()))
+			{
+				bestProfit = profit;
+				bestShifts = shifts;
+			}
+		};
+
+		auto isMachineInChain =
+			[machineID0](const std::vector<Shift>& shifts, MachineID machineID)
+		{
+			if (machineID == machineID0)
+				return true;
+
+			for (const Shift& shift : shifts)
+			{
+				if (shift.machineID == machineID)
+					return true;
+			}
+
+			return false;
+		};
+
+		kernels.filterMachines(mData->getResourceRequirements(processID0).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), nbPaddedResources, mFeasibleMachinesMask.data());
+
+		for (MachineID machineID1 : getCandidateMachines(processID0))
+		{
+			if (!isBlockedTarget(processID0, machineID1))
+				continue;
+
+			pushChain({ { processID0, machineID1 } });
+		}
+
+		for (int64 expansionID = 0; expansionID < sMaxEjectionChainExpansions && !frontier.empty(); ++expansionID)
+		{
+			const EjectionChain chain = frontier.top();
+			frontier.pop();
+
+			// The estimate was compared against an older best chain
+			if (chain.gainEstimate <= bestProfit)
+				continue;
+
+			const Shift& lastShift = chain.shifts.back();
+			const bool canBeExtended = static_cast<int64>(chain.shifts.size()) + 1 < sMaxEjectionChainLength;
+
+			const auto& machineProcessesIDs = mMachinesProcesses[lastShift.machineID];
+			for (int64 processIndex = 0; processIndex < static_cast<int64>(machineProcessesIDs.size()); ++processIndex)
+			{
+				const ProcessID ejectedProcessID = machineProcessesIDs[processIndex];
+
+				if (!doesProcessFitInstead(lastShift.processID, ejectedProcessID))
+					continue;
+
+				candidateShifts = chain.shifts;
+				candidateShifts.push_back({ ejectedProcessID, machineID0 });
+
+				// Taking the first process's place closes the chain as a cycle
+				if (isMachineAllowed(ejectedProcessID, machineID0) && doesProcessFitInstead(ejectedProcessID, processID0))
+					tryCompleteChain(candidateShifts);
+
+				kernels.filterMachines(mData->getResourceRequirements(ejectedProcessID).data(), mMachinesFreeCapacities.data(), mData->getNbMachines(), nbPaddedResources, mFeasibleMachinesMask.data());
+				if (canBeExtended)
+					kernels.filterMachines(mData->getResourceRequirements(ejectedProcessID).data(), mMachinesSwapHeadrooms.data(), mData->getNbMachines(), nbPaddedResources, mChainedFeasibleMachinesMask.data());
+
+				for (MachineID machineID : getCandidateMachines(ejectedProcessID))
+				{
+					if (isMachineInChain(chain.shifts, machineID) || !isMachineAllowed(ejectedProcessID, machineID))
+						continue;
+
+					candidateShifts.back().machineID = machineID;
+
+					if (Kernels::isMachineInMask(mFeasibleMachinesMask.data(), machineID))
+						tryCompleteChain(candidateShifts);
+					else if (canBeExtended && Kernels::isMachineInMask(mChainedFeasibleMachinesMask.data(), machineID))
+						pushChain(candidateShifts);
+				}
+			}
+		}
+
+		if (bestProfit > 0)
+			commitMove(bestShifts.data(), bestShifts.size());
+		else
+			setDontLookBit(MoveType::EjectionChain, processID0);
+
+		if (shouldStopCalculating(startTime))
+			return;
+	}
+}
+
+/*
+Only the machines where the costly machine's processes could go are tried as partners, from their candidate lists:
+the other machines cannot take any of them without a larger rearrangement than a pair.
+*/
+void Solver::repackMachinesPairs(const std::chrono::steady_clock::time_point& startTime)
+{
+	std::vector<MachineID> partnersIDs;
+	std::vector<bool> arePartners(mData->getNbMachines(), false);
+
+	for (MachineID machineID1 : getMachinesByCost())
+	{
+		// A repacking can only lower the load and balance costs of the pair, so one of them must have some
+		const bool isCostly1 = getMachineLoadCost(machineID1) + getMachineBalanceCost(machineID1) > 0;
+		if (!isCostly1 || mAreMachinesDrained[machineID1])
+			continue;
+
+		partnersIDs.clear();
+		for (ProcessID processID : mMachinesProcesses[machineID1])
+		{
+			for (MachineID machineID2 : getCandidateMachines(processID))
+			{
+				if (arePartners[machineID2])
+					continue;
+
+				arePartners[machineID2] = true;
+				partnersIDs.push_back(machineID2);
+			}
+		}
+
+		for (MachineID machineID2 : partnersIDs)
+			arePartners[machineID2] = false;
+
+		for (MachineID machineID2 : partnersIDs)
+		{
+			if (machineID2 == machineID1 || mAreMachinesDrained[machineID2])
+				continue;
+
+			repackMachines(machineID1, machineID2);
+
+			if (shouldStopCalculating(startTime))
+				return;
+		}
+	}
+}
+
+/*
+Branch and bound over the machine of each repacked process, the other processes of the pair stay where they are.
+Every resource bounds the requirements sent to machineID1 from both sides: machineID1's capacity from above,
+and from below what machineID2 cannot take. Conflicts are pruned as soon as a process is placed,
+spread, dependency and transient constraints are checked by isMoveValid on the assignments that would be kept.
+A subtree is also pruned when getMoveProfitBound over its placed processes, plus the best each process left to place
+can add on its own, cannot beat the best assignment.
+*/
+void Solver::repackMachines(MachineID machineID1, MachineID machineID2)
+{
+	const int64 nbResources = mData->getNbResources();
+	const MachineID machinesIDs[2] = { machineID1, machineID2 };
+
+	// The largest processes, relative to the pair's capacities, are the ones swaps fail to rearrange
+	std::vector<ProcessID> repackedProcessesIDs = mMachinesProcesses[machineID1];
+	repackedProcessesIDs.insert(repackedProcessesIDs.end(), mMachinesProcesses[machineID2].begin(), mMachinesProcesses[machineID2].end());
+
+	auto getRelativeSize =
+		[this, nbResources, machineID1, machineID2](ProcessID processID)
+	{
+		double relativeSize = 0.0;
+		for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+		{
+			const int64 capacity = mData->getResourceCapacity(machineID1, resourceID) + mData->getResourceCapacity(machineID2, resourceID);
+			if (capacity > 0)
+				relativeSize += static_cast<double>(mData->getResourceRequirement(processID, resourceID)) / capacity;
+		}
+
+		return relativeSize;
+	};
+
+	if (static_cast<int64>(repackedProcessesIDs.size()) > sMaxRepackedProcesses)
+	{
+		std::partial_sort(repackedProcessesIDs.begin(), repackedProcessesIDs.begin() + sMaxRepackedProcesses, repackedProcessesIDs.end(),
+			[&getRelativeSize](ProcessID processID1, ProcessID processID2) { return getRelativeSize(processID1) > getRelativeSize(processID2); });
+		repackedProcessesIDs.resize(sMaxRepackedProcesses);
+	}
+
+	const int64 nbRepackedProcesses = repackedProcessesIDs.size();
+
+	// Requirements bounds of machineID1, and of the processes left to place
+	std::vector<int64> minRequirements(nbResources, 0);
+	std::vector<int64> maxRequirements(nbResources, 0);
+	std::vector<int64> remainingRequirements((nbRepackedProcesses + 1) * nbResources, 0);
+	for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+	{
+		int64 baseUsage1 = mMachinesResourcesUsage[machineID1][resourceID];
+		int64 baseUsage2 = mMachinesResourcesUsage[machineID2][resourceID];
+		for (int64 repackedProcessID = nbRepackedProcesses - 1; repackedProcessID >= 0; --repackedProcessID)
+		{
+			const ProcessID processID = repackedProcessesIDs[repackedProcessID];
+			const int64 requirement = mData->getResourceRequirement(processID, resourceID);
+
+			(mSolution[processID] == machineID1 ? baseUsage1 : baseUsage2) -= requirement;
+			remainingRequirements[repackedProcessID * nbResources + resourceID] = remainingRequirements[(repackedProcessID + 1) * nbResources + resourceID] + requirement;
+		}
+
+		maxRequirements[resourceID] = mData->getResourceCapacity(machineID1, resourceID) - baseUsage1;
+		minRequirements[resourceID] = remainingRequirements[resourceID] - (mData->getResourceCapacity(machineID2, resourceID) - baseUsage2);
+	}
+
+	// Machines of the pair already holding a process of the same service that is not repacked, one bit per machine
+	std::vector<int64> forbiddenMachines(nbRepackedProcesses, 0);
+	for (int64 repackedProcessID = 0; repackedProcessID < nbRepackedProcesses; ++repackedProcessID)
+	{
+		const ProcessID processID = repackedProcessesIDs[repackedProcessID];
+
+		for (ProcessID otherProcessID : mData->getServiceProcessesIDs(mData->getServiceID(processID)))
+		{
+			const bool isRepacked = std::find(repackedProcessesIDs.begin(), repackedProcessesIDs.end(), otherProcessID) != repackedProcessesIDs.end();
+			if (isRepacked)
+				continue;
+
+			if (mSolution[otherProcessID] == machineID1)
+				forbiddenMachines[repackedProcessID] |= BIT(0);
+			else if (mSolution[otherProcessID] == machineID2)
+				forbiddenMachines[repackedProcessID] |= BIT(1);
+		}
+	}
+
+	// getMoveProfitBound is subadditive over the shifts, so the bounds of the single shifts add up to a bound of the processes left to place
+	std::vector<int64> remainingProfitBounds(nbRepackedProcesses + 1, 0);
+	for (int64 repackedProcessID = nbRepackedProcesses - 1; repackedProcessID >= 0; --repackedProcessID)
+	{
+		const ProcessID processID = repackedProcessesIDs[repackedProcessID];
+		const Shift shift = { processID, mSolution[processID] == machineID1 ? machineID2 : machineID1 };
+		remainingProfitBounds[repackedProcessID] = remainingProfitBounds[repackedProcessID + 1] + std::max<int64>(getMoveProfitBound(&shift, 1), 0);
+	}
+
+	std::vector<int64> assignment(nbRepackedProcesses, 0);
+	std::vector<int64> requirements1(nbResources, 0);
+	std::vector<Shift> shifts;
+	std::vector<Shift> bestShifts;
+	int64 bestProfit = 0;
+
+	auto placeShifts =
+		[&](int64 nbPlacedProcesses)
+	{
+		shifts.clear();
+		for (int64 processIndex = 0; processIndex < nbPlacedProcesses; ++processIndex)
+		{
+			const ProcessID processID = repackedProcessesIDs[processIndex];
+			if (mSolution[processID] != machinesIDs[assignment[processIndex]])
+				shifts.push_back({ processID, machinesIDs[assignment[processIndex]] });
+		}
+	};
+
+	std::function<void(int64)> branch =
+		[&](int64 repackedProcessID)
+	{
+		placeShifts(repackedProcessID);
+
+		const int64 placedProfitBound = shifts.empty() ? 0 : getMoveProfitBound(shifts.data(), shifts.size());
+		if (placedProfitBound + remainingProfitBounds[repackedProcessID] <= bestProfit)
+			return;
+
+		if (repackedProcessID == nbRepackedProcesses)
+		{
+			if (shifts.empty())
+				return;
+
+			const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+			if (profit > bestProfit && isMoveValid(shifts.data(), shifts.size()))
+			{
+				bestProfit = profit;
+				bestShifts = shifts;
+			}
+
+			return;
+		}
+
+		const ProcessID processID = repackedProcessesIDs[repackedProcessID];
+		const int64* requirements = mData->getResourceRequirements(processID).data();
+
+		for (int64 machineIndex = 0; machineIndex < 2; ++machineIndex)
+		{
+			if (forbiddenMachines[repackedProcessID] & BIT(machineIndex))
+				continue;
+
+			bool isConflicting = false;
+			for (int64 otherProcessIndex = 0; otherProcessIndex < repackedProcessID && !isConflicting; ++otherProcessIndex)
+			{
+				isConflicting = assignment[otherProcessIndex] == machineIndex
+							 && mData->getServiceID(repackedProcessesIDs[otherProcessIndex]) == mData->getServiceID(processID);
+			}
+
+			if (isConflicting)
+				continue;
+
+			if (machineIndex == 0)
+			{
+				for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+					requirements1[resourceID] += requirements[resourceID];
+			}
+
+			bool isFeasible = true;
+			for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+			{
+				isFeasible &= requirements1[resourceID] <= maxRequirements[resourceID]
+						   && requirements1[resourceID] + remainingRequirements[(repackedProcessID + 1) * nbResources + resourceID] >= minRequirements[resourceID];
+			}
+
+			if (isFeasible)
+			{
+				assignment[repackedProcessID] = machineIndex;
+				branch(repackedProcessID + 1);
+			}
+
+			if (machineIndex == 0)
+			{
+				for (ResourceID resourceID = 0; resourceID < nbResources; ++resourceID)
+					requirements1[resourceID] -= requirements[resourceID];
+			}
+		}
+	};
+
+	branch(0);
+
+	if (bestProfit > 0)
+		commitMove(bestShifts.data(), bestShifts.size());
+}
+
+void Solver::drainMachinesAsBestFit(const std::chrono::steady_clock::time_point& startTime)
+{
+	for (MachineID machineID : getMachinesByCost())
+	{
+		// Emptying a machine only pays off through its own load and balance costs
+		if (mMachinesProcesses[machineID].empty() || getMachineLoadCost(machineID) + getMachineBalanceCost(machineID) == 0)
+			continue;
+
+		drainMachine(machineID, false);
+
+		if (shouldStopCalculating(startTime))
+			return;
+	}
+}
+
+void Solver::drainForcedMachines()
+{
+	for (MachineID machineID : mOptions.drainedMachinesIDs)
+	{
+		if (!mAreMachinesDrained[machineID] || mMachinesProcesses[machineID].empty())
+			continue;
+
+		if (drainMachine(machineID, true))
+			APP_INFO("Machine {0} drained.", machineID);
+	}
+}
+
+/*
+The processes are placed one by one, largest first, each on the valid machine where it is the most profitable.
+Each placement is committed so that the next ones see it, and they are all rolled back if the drain fails or does not pay off.
+A forced drain keeps the processes it could place, the others are tried again on the next pass.
+*/
+bool Solver::drainMachine(MachineID machineID, bool isForced)
+{
+	const Kernels::KernelTable& kernels = mChecker->getKernels();
+
+	std::vector<ProcessID> drainedProcessesIDs = mMachinesProcesses[machineID];
+	std::sort(drainedProcessesIDs.begin(), drainedProcessesIDs.end(),
+		[this](ProcessID processID1, ProcessID processID2)
+		{
+			const auto& requirements1 = mData->getResourceRequirements(processID1);
+			const auto& requirements2 = mData->getResourceRequirements(processID2);
+			return std::accumulate(requirements1.begin(), requirements1.end(), 0LL) > std::accumulate(requirements2.begin(), requirements2.end(), 0LL);
+		});
+
+	std::vector<Shift> committedShifts;
+	int64 totalProfit = 0;
+	bool isDrained = true;
+
+	for (ProcessID processID : drainedProcessesIDs)
+	{
+		kernels.filterMachines(mData->getResourceRequirements(processID).data(), mMachinesFreeCapacities.data(), mData->getNbMachines(), mData->getNbPaddedResources(), mFeasibleMachinesMask.data());
+
+		int64 bestProfit = std::numeric_limits<int64>::min();
+		MachineID bestMachineID = INT64_MAX;
+		for (MachineID targetMachineID = 0; targetMachineID < mData->getNbMachines(); ++targetMachineID)
+		{
+			if (targetMachineID == machineID || !Kernels::isMachineInMask(mFeasibleMachinesMask.data(), targetMachineID) || !isMachineAllowed(processID, targetMachineID))
+				continue;
+
+			const Shift shift = { processID, targetMachineID };
+			if (getMoveProfitBound(&shift, 1) <= bestProfit)
+				continue;
+
+			const int64 profit = getMoveProfit(&shift, 1);
+			if (profit > bestProfit && isMoveValid(&shift, 1))
+			{
+				bestProfit = profit;
+				bestMachineID = targetMachineID;
+			}
+		}
+
+		if (bestMachineID == INT64_MAX)
+		{
+			isDrained = false;
+
+			if (!isForced)
+				break;
+
+			continue;
+		}
+
+		const Shift shift = { processID, bestMachineID };
+		commitMove(&shift, 1);
+
+		committedShifts.push_back({ processID, machineID });
+		totalProfit += bestProfit;
+	}
+
+	if (isForced || (isDrained && totalProfit > 0))
+		return isDrained;
+
+	// Sent back in reverse order, the intermediate states were all valid
+	for (auto shift = committedShifts.rbegin(); shift != committedShifts.rend(); ++shift)
+		commitMove(&*shift, 1);
+
+	return false;
+}
+
+/*
+A block is every process of a service in one location, moved together to another location, each process on its most profitable machine there.
+Moving them one at a time can lower the service's spread midway, the block only changes it once: the source location is left,
+and the destination one is gained if the service was not there yet. The dependency counts tell which target machines
+have every dependency of the service in their neighbourhood, the rest is checked by isMoveValid on the whole block.
+*/
+void Solver::moveServicesBlocks(const std::chrono::steady_clock::time_point& startTime)
+{
+	std::vector<ProcessID> blockProcessesIDs;
+	std::vector<MachineID> serviceMachinesIDs;
+	std::vector<Shift> shifts;
+	std::vector<Shift> bestShifts;
+
+	for (ServiceID serviceID = 0; serviceID < mData->getNbServices(); ++serviceID)
+	{
+		const auto& serviceProcessesIDs = mData->getServiceProcessesIDs(serviceID);
+		for (LocationID sourceLocationID = 0; sourceLocationID < mData->getNbLocations(); ++sourceLocationID)
+		{
+			// A block of one process is a shift
+			const int64 blockSize = mServicesLocationsSpread[serviceID][sourceLocationID];
+			if (blockSize < 2 || blockSize > sMaxServiceBlockSize)
+				continue;
+
+			blockProcessesIDs.clear();
+			serviceMachinesIDs.clear();
+			for (ProcessID processID : serviceProcessesIDs)
+			{
+				serviceMachinesIDs.push_back(mSolution[processID]);
+				if (mData->getMachineLocation(mSolution[processID]) == sourceLocationID)
+					blockProcessesIDs.push_back(processID);
+			}
+
+			int64 bestProfit = 0;
+			bestShifts.clear();
+
+			for (LocationID targetLocationID = 0; targetLocationID < mData->getNbLocations(); ++targetLocationID)
+			{
+				const int64 newSpread = mServicesSpreads[serviceID] - 1 + (mServicesLocationsSpread[serviceID][targetLocationID] == 0 ? 1 : 0);
+				if (targetLocationID == sourceLocationID || newSpread < mData->getServiceSpreadMin(serviceID))
+					continue;
+
+				shifts.clear();
+				for (ProcessID processID : blockProcessesIDs)
+				{
+					int64 bestTargetProfit = std::numeric_limits<int64>::min();
+					MachineID bestTargetMachineID = INT64_MAX;
+
+					for (MachineID machineID : mData->getLocationMachinesIDs(targetLocationID))
+					{
+						// Each machine of the location takes at most one process of the service, and the block only arrives in the location
+						const bool isConflicting = std::find(serviceMachinesIDs.begin(), serviceMachinesIDs.end(), machineID) != serviceMachinesIDs.end()
+												|| std::find_if(shifts.begin(), shifts.end(), [machineID](const Shift& shift) { return shift.machineID == machineID; }) != shifts.end();
+						if (isConflicting || mAreMachinesDrained[machineID] || !isMachineAllowed(processID, machineID) || !doesProcessFit(processID, machineID))
+							continue;
+
+						shifts.push_back({ processID, machineID });
+						const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+						shifts.pop_back();
+
+						if (profit > bestTargetProfit)
+						{
+							bestTargetProfit = profit;
+							bestTargetMachineID = machineID;
+						}
+					}
+
+					if (bestTargetMachineID == INT64_MAX)
+						break;
+
+					shifts.push_back({ processID, bestTargetMachineID });
+				}
+
+				if (shifts.size() != blockProcessesIDs.size())
+					continue;
+
+				const int64 profit = getMoveProfit(shifts.data(), shifts.size());
+				if (profit > bestProfit && isMoveValid(shifts.data(), shifts.size()))
+				{
+					bestProfit = profit;
+					bestShifts = shifts;
+				}
+			}
+
+			if (bestProfit > 0)
+				commitMove(bestShifts.data(), bestShifts.size());
+		}
+
+		if (shouldStopCalculating(startTime))
+			return;
+	}
+}
+
+bool shouldStopCalculating(const std::chrono::steady_clock::time_point& startTime)
+{
+	constexpr std::chrono::duration stopTime = std::chrono::minutes(sTimeOutMin);
+	const auto currentTime = std::chrono::steady_clock::now();
 
 	return std::chrono::duration_cast<std::chrono::minutes>(currentTime - startTime) >= stopTime;
 
 }
+
+double getElapsedTimeFraction(const std::chrono::steady_clock::time_point& startTime)
+{
+	const std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+
+	return elapsedTime / std::chrono::minutes(sTimeOutMin);
+}
@@ -3,7 +3,13 @@
 #include "Data/Data.hpp"
 #include "Checker/MicroChecker.hpp"
 #include "Checker/FullChecker.hpp"
+#include "Solver/EjectionChain.hpp"
+#include "Solver/Shift.hpp"
+#include "Solver/SolverOptions.hpp"
 #include "Solver/Swap.hpp"
+#include "Hash/Zobrist.hpp"
+#include "Queue/IndexedPriorityQueue.hpp"
+#include "Random/Random.hpp"
 
 #include <chrono>
 #include <memory>
@@ -16,24 +22,255 @@ enum SwapFlag : int64
 	IntraService = BIT(1)
 };
 
+enum class DestroyOperator : int64
+{
+	Random,
+	CostlyMachines,
+	RelatedServices,
+	Neighbourhood,
+	Location,
+
+	Count
+};
+
+enum class RepairOperator : int64
+{
+	Greedy,
+	Regret,
+	Randomised,
+
+	Count
+};
+
+enum class MoveType : int64
+{
+	Swap,
+	Shift,
+	DoubleShift,
+	Cycle,
+	EjectionChain,
+
+	Count
+};
+
+// Hard constraint checks of isMoveValid, in their initial order
+enum class ConstraintCheck : int64
+{
+	Capacity,
+	Conflict,
+	Spread,
+	Dependency,
+	Transient,
+
+	Count
+};
+
+struct ConstraintCheckStatistics
+{
+	int64 nbCalls = 0;
+	int64 nbRejections = 0;
+
+	// Only one validation in sConstraintChecksTimingPeriod is timed, timing them all would cost more than some checks
+	int64 nbTimedCalls = 0;
+	int64 timedNanoseconds = 0;
+};
+
 class Solver
 {
 public:
 	Solver() = default;
+	Solver(const SolverOptions& options) : mOptions(options) {}
 
 	void solveInstance(const std::shared_ptr<Data>& data);
 
+	// Replays random moves and compares every predicted cost with a full recalculation, returns whether they all matched
+	bool checkDeltaEvaluation(const std::shared_ptr<Data>& data, int64 nbMoves);
+
+	inline uint64 getSolutionHash() const { return mSolutionHash; }
+
+	const Costs getCurrentCosts();
+
 private:
+	void initialiseState(const std::shared_ptr<Data>& data);
+
+	// Search drivers, selected by SolverOptions::searchMode
+	void descend(const std::chrono::steady_clock::time_point& startTime);
+	void searchRandomised(const std::chrono::steady_clock::time_point& startTime);
+	void anneal(const std::chrono::steady_clock::time_point& startTime);
+	void searchTabu(const std::chrono::steady_clock::time_point& startTime);
+	void acceptLate(const std::chrono::steady_clock::time_point& startTime);
+	void searchVariableNeighbourhoods(const std::chrono::steady_clock::time_point& startTime);
+	void searchIteratedLocally(const std::chrono::steady_clock::time_point& startTime);
+	void searchAdaptiveLargeNeighbourhoods(const std::chrono::steady_clock::time_point& startTime);
+	void initialiseNeighbourhoods();
+	// Descends through the neighbourhoods by increasing measured time per pass, back to the cheapest one after each improvement
+	void descendVariableNeighbourhoods(const std::chrono::steady_clock::time_point& startTime);
+	// Commits up to nbMoves random feasible moves, whatever their profit
+	void shakeSolution(int64 nbMoves);
+	// Same, but the moved processes are taken from the sPerturbedMachines most costly machines
+	void perturbCostlyMachines(int64 nbMoves);
+
+	// A shift or a swap of a random process with one of its candidate machines, false when the draw is not worth evaluating
+	bool drawRandomMove(std::vector<Shift>& shifts);
+	// Temperature at which a worsening move of average size is accepted with a given probability, from sampled feasible moves
+	double calibrateTemperature();
+
+	/*
+	Best solution met by the searches that accept worsening moves. It is kept as the list of shifts to undo from the current solution,
+	and only copied once that list grows longer than the solution itself.
+	*/
+	void resetBestSolution();
+	void commitTrackedMove(const Shift* shifts, int64 nbShifts, int64 profit);
+	void restoreBestSolution();
+	// Moves every process back to its machine in the solution, through any solution in between
+	void restoreSolution(const Solution& solution);
+
+	/*
+	The incremental state has no room for unassigned processes: a destroyed process is moved to a random feasible candidate machine instead,
+	which frees its machine as removing it would, and repairing it may bring it back. Every move is feasible and tracked by commitTrackedMove.
+	*/
+	void selectDestroyedProcesses(DestroyOperator destroyOperator, int64 nbProcesses, std::vector<ProcessID>& processesIDs);
+	void destroyProcesses(const std::vector<ProcessID>& processesIDs);
+	void repairProcesses(RepairOperator repairOperator, std::vector<ProcessID> processesIDs);
+	// The nbInsertions most profitable feasible shifts of the process onto its candidate machines, staying where it is included, best first
+	void getBestInsertions(ProcessID processID, int64 nbInsertions, std::vector<std::pair<int64, MachineID>>& insertions);
+	void updateOperatorsWeights();
+
+	// Tabu attributes are (process, machine) pairs: a process may not go back to a machine it left for a while
+	bool isMoveTabu(const Shift* shifts, int64 nbShifts, int64 iterationID) const;
+	void makeMoveTabu(const std::vector<MachineID>& oldMachinesIDs, const Shift* shifts, int64 nbShifts, int64 expiryIterationID);
+
 	bool isSwapValid(const Swap& swap, const int flags = SwapFlag::None);
 	int64 getSwapProfit(const Swap& swap);
-	void applySwap(const Swap& swap);
+	int64 getSwapProfitBound(const Swap& swap);
+	void commitSwap(const Swap& swap);
+
+	// Applies the shifts, checks every hard constraint they can break against the incremental structures, then rolls them back
+	// The machines' process lists get their order back, but grow during the checks: callers iterating over them go by index
+	bool isMoveValid(const Shift* shifts, int64 nbShifts, const int flags = SwapFlag::None);
+	bool isConstraintRespected(ConstraintCheck check, const Shift* shifts, int64 nbShifts);
+	// The checks that are cheap and often reject go first: by increasing time per call over rejection rate
+	void reorderConstraintChecks();
+	void logConstraintChecksStatistics();
+
+	// Exact decrease of the total weighted cost if the shifts were applied in order, the state is left untouched
+	int64 getMoveProfit(const Shift* shifts, int64 nbShifts);
+	// Upper bound of getMoveProfit from the cached machine costs, cheap enough to discard most candidates before the exact profit and isMoveValid
+	int64 getMoveProfitBound(const Shift* shifts, int64 nbShifts);
+	void commitMove(const Shift* shifts, int64 nbShifts);
+
+	// Keeps every incremental structure up to date, but not the cost caches: use commitMove for moves that are kept
+	void moveProcess(ProcessID processID, MachineID newMachineID);
+
+	void initialiseMachinesCosts();
+	void markMachineDirty(MachineID machineID);
+	void refreshMachineCosts(MachineID machineID);
+	void refreshDirtyMachinesCosts();
+	int64 getMachineLoadCost(MachineID machineID);
+	int64 getMachineBalanceCost(MachineID machineID);
+
+	// Hotspots first: machines by decreasing load plus balance cost, and their processes in that order
+	std::vector<MachineID> getMachinesByCost();
+	std::vector<ProcessID> getProcessesByMachineCost();
+
+	void initialiseMachinesHeadrooms();
+	void refreshMachineHeadrooms(MachineID machineID);
+
+	/*
+	Short list of the most promising target machines of a process, ranked by the move costs and the load and balance costs the process would add there.
+	Only the machines where the process fits once one of their processes left, and where every dependency of its service runs, are listed.
+	A list is rebuilt when it is accessed, if the process or a listed machine changed since, or if it is too old to trust for the other machines.
+	*/
+	const std::vector<MachineID>& getCandidateMachines(ProcessID processID);
+	void initialiseCandidateMachines();
+	void refreshCandidateMachines(ProcessID processID);
+	bool areCandidateMachinesStale(ProcessID processID);
+
+	// Don't-look bits: a move type skips a process it found no improving move for, until the process's machine or one of its candidate machines changes
+	void initialiseDontLookBits();
+	bool isDontLookBitSet(MoveType moveType, ProcessID processID);
+	void setDontLookBit(MoveType moveType, ProcessID processID);
+
+	/*
+	A neighbourhood is allowed for a service when every one of its dependencies runs there, so that a process of the service can arrive.
+	The number of missing dependencies only changes when a service enters or leaves a neighbourhood, which moveProcess tracks.
+	*/
+	void initialiseAllowedNeighbourhoods();
+	std::vector<std::vector<uint64>> calculateAllowedNeighbourhoodsMasks() const;
+	void updateAllowedNeighbourhoods(ServiceID dependencyID, NeighbourhoodID neighbourhoodID, int64 nbMissingDependenciesDelta);
+	bool isNeighbourhoodAllowed(ServiceID serviceID, NeighbourhoodID neighbourhoodID) const { return (mServicesAllowedNeighbourhoodsMasks[serviceID][neighbourhoodID / 64] >> (neighbourhoodID % 64)) & 1; }
+	bool isMachineAllowed(ProcessID processID, MachineID machineID) const { return isNeighbourhoodAllowed(mData->getServiceID(processID), mData->getMachineNeighbourhood(machineID)); }
+
+	// Capacity only, from the free capacities: whether the process fits on the machine, or fits once leavingProcessID left its machine
+	bool doesProcessFit(ProcessID processID, MachineID machineID);
+	bool doesProcessFitInstead(ProcessID processID, ProcessID leavingProcessID);
+	// Machine of mFeasibleMachinesMask that the process may go to but does not fit on without making room first
+	bool isBlockedTarget(ProcessID processID, MachineID machineID);
 
 	void swapProcessesIntraServices(const std::chrono::steady_clock::time_point& startTime);
 	void swapProcessesBruteForceAsBestFit(const std::chrono::steady_clock::time_point& startTime);
+	void shiftProcessesAsBestFit(const std::chrono::steady_clock::time_point& startTime);
+	void moveProcessesAsFirstFit(const std::chrono::steady_clock::time_point& startTime);
+
+	// Compound moves, only tried once the simple ones stall
+	void applyCompoundMoves(const std::chrono::steady_clock::time_point& startTime);
+	void doubleShiftProcesses(const std::chrono::steady_clock::time_point& startTime);
+	void cycleProcesses(const std::chrono::steady_clock::time_point& startTime);
+	void ejectProcesses(const std::chrono::steady_clock::time_point& startTime);
 
-	std::vector<ServiceID> getDependingServices(ServiceID serviceID);
+	// Exact reassignment of the largest processes of two machines between them, committed if it is cheaper
+	void repackMachines(MachineID machineID1, MachineID machineID2);
+	void repackMachinesPairs(const std::chrono::steady_clock::time_point& startTime);
+
+	// Moves every process off the machine, returns whether it is empty. Rolled back if it fails or does not pay off, unless it is forced
+	bool drainMachine(MachineID machineID, bool isForced);
+	void drainMachinesAsBestFit(const std::chrono::steady_clock::time_point& startTime);
+	void drainForcedMachines();
+
+	void moveServicesBlocks(const std::chrono::steady_clock::time_point& startTime);
 
 private:
+	SolverOptions mOptions;
+	Random mRandom;
+
+	int64 mTrackedCost = 0; // Current cost, kept up to date by commitTrackedMove
+	int64 mBestCost = 0;
+	Solution mBestSolution;
+	bool mIsBestSolutionCopied = false;
+	std::vector<Shift> mBestSolutionUndoShifts;
+
+	typedef void (Solver::*NeighbourhoodDriver)(const std::chrono::steady_clock::time_point& startTime);
+	struct Neighbourhood
+	{
+		const char* name;
+		NeighbourhoodDriver driver;
+
+		int64 nbPasses = 0;
+		double totalSeconds = 0.0;
+	};
+
+	std::vector<Neighbourhood> mNeighbourhoods; // Sorted by increasing time per pass
+
+	struct SearchOperator
+	{
+		double weight = 1.0;
+
+		// Since the last weights update
+		int64 nbUses = 0;
+		int64 nbSuccesses = 0;
+		int64 gain = 0;
+		double seconds = 0.0;
+
+		int64 nbTotalUses = 0;
+		int64 totalGain = 0;
+	};
+
+	std::vector<SearchOperator> mDestroyOperators; // [DestroyOperator]
+	std::vector<SearchOperator> mRepairOperators; // [RepairOperator]
+
+	// Iteration until which a (process, machine) pair is tabu, indexed by the low bits of its Zobrist key, collisions only make a few moves tabu
+	std::vector<int64> mTabuExpiryIterations;
+
 	std::shared_ptr<Data> mData;
 	std::shared_ptr<MicroChecker> mChecker;
 	std::shared_ptr<FullChecker> mFullChecker;
@@ -43,7 +280,64 @@ private:
 
 	ServicesLocationsSpreads mServicesLocationsSpread;
 	std::vector<int64> mServicesSpreads;
-	std::vector<int64> mServicesCost;
+	ServicesNeighbourhoodsCounts mServicesNeighbourhoodsCount; // Number of processes of the service in the neighbourhood
+	ServicesNeighbourhoodsCounts mServicesNeighbourhoodsMissingDependencies; // Number of dependencies of the service without a process in the neighbourhood
+	std::vector<std::vector<uint64>> mServicesAllowedNeighbourhoodsMasks; // [ServiceID][NeighbourhoodID / 64], bit set when no dependency is missing
+	std::vector<int64> mServicesCost; // Number of moved processes per service
+
+	std::vector<bool> mAreMachinesDrained; // No process may be moved onto a force-drained machine
+
+	// Number of services per number of moved processes, so that the largest one is known without going through every service
+	std::vector<int64> mServicesCostFrequencies;
+	int64 mMaxServiceCost = 0;
+
+	// Unweighted process and machine move costs
+	int64 mProcessMoveCost = 0;
+	int64 mMachineMoveCost = 0;
+
+	// Cached per machine costs, only recalculated once a committed move changed the machine's usage
+	std::vector<int64> mMachinesLoadCost;
+	std::vector<int64> mMachinesBalanceCost;
+	std::vector<bool> mAreMachinesDirty;
+	std::vector<MachineID> mDirtyMachinesIDs;
+
+	int64 mLoadCost = 0;
+	int64 mBalanceCost = 0;
+
+	IndexedPriorityQueue mMachinesCostQueue; // Keyed by the cached load plus balance cost
+
+	// Contiguous [MachineID][padded ResourceID] headrooms for the batched capacity filter, refreshed on commit
+	std::vector<int64> mMachinesFreeCapacities;
+	std::vector<int64> mMachinesSwapHeadrooms; // Free capacity plus the largest requirement among the machine's processes
+	std::vector<uint64> mFeasibleMachinesMask;
+	std::vector<uint64> mChainedFeasibleMachinesMask; // Targets of the second process of a compound move
+
+	std::vector<std::vector<MachineID>> mProcessesCandidateMachinesIDs;
+	std::vector<int64> mCandidateMachinesStamps;	// Number of committed shifts when the process's list was built
+	std::vector<int64> mMachinesChangeStamps;		// Number of committed shifts when the machine last changed
+	int64 mNbCommittedShifts = 0;
+	std::vector<uint64> mCandidateMachinesMask;
+	std::vector<int64> mCandidateMachineResourcesUsage;
+	std::vector<std::pair<int64, MachineID>> mCandidateMachinesScores;
+
+	std::vector<std::vector<int64>> mDontLookStamps; // [MoveType][ProcessID], number of committed shifts when the bit was set, or -1
+
+	// Scratch buffers of getMoveProfit, kept between calls to avoid allocations
+	std::vector<MachineID> mTouchedMachinesIDs;
+	std::vector<int64> mTouchedMachinesResourcesUsage; // [touched machine][padded ResourceID]
+	std::vector<ProcessID> mMovedProcessesIDs;
+	std::vector<MachineID> mMovedProcessesMachinesIDs;
+	std::vector<ServiceID> mChangedServicesIDs;
+	std::vector<int64> mChangedServicesCosts;
+
+	// Machines of the shifted processes before isMoveValid applied them, to roll the move back
+	std::vector<MachineID> mValidatedMovesOldMachinesIDs;
+	std::vector<int64> mValidatedMovesOldPositions; // In the old machines' process lists
+
+	std::vector<ConstraintCheck> mConstraintChecksOrder;
+	std::vector<ConstraintCheckStatistics> mConstraintChecksStatistics; // [ConstraintCheck]
+	int64 mNbValidatedMoves = 0;
 
 	Solution mSolution;
+	uint64 mSolutionHash = 0;
 };
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <vector>
+
+enum class SearchMode
+{
+	Descent,		// Best improvement over every move type, deterministic
+	Randomised,		// First improvement over shuffled processes and target machines
+	Annealing,		// Simulated annealing over random shifts and swaps, then a descent from the best solution
+	Tabu,			// Tabu search over sampled shifts and swaps, then a descent from the best solution
+	LateAcceptance,	// Late acceptance hill climbing over random shifts and swaps, then a descent from the best solution
+	VariableNeighbourhoods, // Descent from the cheapest neighbourhood that still improves, shaken by random moves once they are all exhausted
+	IteratedLocalSearch,	// Descent, perturbation of the most costly machines, descent again, and so on
+	AdaptiveLargeNeighbourhoods // Destroy and repair operators, picked by weights adapted to their results
+};
+
+struct SolverOptions
+{
+	std::vector<MachineID> drainedMachinesIDs; // Emptied before the search starts, and kept empty until it ends
+
+	SearchMode searchMode = SearchMode::Descent;
+	uint64 seed = 0; // Runs of the randomised searches with the same seed are identical, up to the time limit
+
+	double initialTemperature = 0.0; // Of the annealing, calibrated from sampled moves when it is not positive
+	int64 historyLength = 0; // Of the late acceptance, scaled with the number of processes when it is not positive
+	double acceptanceThreshold = 0.0; // Of the iterated local search, relative to the best cost: 0 only accepts solutions at least as good as the current one
+};